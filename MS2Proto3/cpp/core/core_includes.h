@@ -47,5 +47,7 @@ const Int32 Int32MinValue = -2147483648;
 const Int32 Int32MaxValue = 2147483647;
 const UInt32 UInt32MinValue = 0;
 const UInt32 UInt32MaxValue = 4294967295U;
+const Int64 Int64MinValue = INT64_MIN;
+const Int64 Int64MaxValue = INT64_MAX;
 
 #endif // CORE_INCLUDES_H
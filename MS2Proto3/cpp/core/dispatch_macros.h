@@ -1,8 +1,23 @@
-// This header defines macros used to encapsulate two different approaches
+// This header defines macros used to encapsulate four different approaches
 // to opcode dispatch in the C++ version of the VM:
 //
 //	1. Computed-goto (using a list of labels, one per opcode).
 //	2. An ordinary `switch` statement (just like the C# version).
+//	3. Direct threading: computed-goto, but with each function's code also
+//	   translated (when the VM starts running) into a parallel array of
+//	   handler addresses, so dispatch needn't decode the opcode or index
+//	   the label list; it just jumps to the address for the current PC.
+//	4. Tail calls: the transpiler also copies the body of each opcode's case
+//	   into a method of its own (Tail_<opcode>), and each of these ends by
+//	   calling the handler of the next instruction, passing the hottest VM
+//	   state (pc, register window, constants, code and cycle budget) as
+//	   arguments.  Those calls must compile to jumps: we ask for that with
+//	   `musttail` where the compiler supports it, and otherwise rely on the
+//	   optimizer (GCC does it at -O2 and up).  Each handler thus gets its own
+//	   register allocation, instead of sharing that of one giant function.
+
+#ifndef DISPATCH_MACROS_H
+#define DISPATCH_MACROS_H
 
 // This file is part of Layer 0 (foundation utilities)
 #define CORE_LAYER_0
@@ -22,6 +37,24 @@
 #  endif
 #endif
 
+// Direct threading is off unless asked for (-DVM_USE_THREADED_CODE=1),
+// and requires computed-goto.
+#ifndef VM_USE_THREADED_CODE
+#  define VM_USE_THREADED_CODE 0
+#endif
+#if VM_USE_THREADED_CODE && !VM_USE_COMPUTED_GOTO
+#  error "VM_USE_THREADED_CODE requires VM_USE_COMPUTED_GOTO"
+#endif
+
+// Tail-call dispatch is likewise off unless asked for (-DVM_USE_TAIL_CALLS=1).
+// Run still contains the ordinary dispatch loop, but doesn't use it.
+#ifndef VM_USE_TAIL_CALLS
+#  define VM_USE_TAIL_CALLS 0
+#endif
+#if VM_USE_TAIL_CALLS && VM_USE_THREADED_CODE
+#  error "VM_USE_TAIL_CALLS and VM_USE_THREADED_CODE are mutually exclusive"
+#endif
+
 // X-macro defining all opcodes - must match the C# Opcode enum exactly
 #define VM_OPCODES(X) \
 	X(NOOP) \
@@ -83,9 +116,34 @@
 	X(ARG_rA) \
 	X(ARG_iABC) \
 	X(CALLF_iA_iBC) \
+	X(TAILCALLF_iA_iBC) \
 	X(CALLFN_iA_kBC) \
 	X(CALL_rA_rB_rC) \
-	X(RETURN)
+	X(RETURN) \
+	X(FORPREP_rA_iBC) \
+	X(FORLOOP_rA_iBC) \
+	X(ITER_INIT_rA_rB) \
+	X(ITER_NEXT_rA_iBC) \
+	X(ADD_INT_rA_rB_rC) \
+	X(ADD_DBL_rA_rB_rC) \
+	X(SUB_INT_rA_rB_rC) \
+	X(SUB_DBL_rA_rB_rC) \
+	X(MULT_INT_rA_rB_rC) \
+	X(MULT_DBL_rA_rB_rC) \
+	X(LT_INT_rA_rB_rC) \
+	X(LE_INT_rA_rB_rC) \
+	X(BRLT_INT_rA_rB_iC) \
+	X(BRLT_INT_rA_iB_iC) \
+	X(BRLE_INT_rA_rB_iC) \
+	X(BRLE_INT_rA_iB_iC) \
+	X(IFLT_INT_rA_rB) \
+	X(IFLT_INT_rA_iBC) \
+	X(IFLE_INT_rA_rB) \
+	X(IFLE_INT_rA_iBC) \
+	X(IFLTI_RET) \
+	X(SUBI_CALLF) \
+	X(ADD_BRLT) \
+	X(ADD_BRLE)
 
 
 #if VM_USE_COMPUTED_GOTO
@@ -95,9 +153,27 @@
 	#define VM_LABEL_LIST(OP) VM_LABEL_ADDR(OP),
 
 	#define VM_DISPATCH_TOP() vm_dispatch_top:
+#if VM_USE_THREADED_CODE
+	#define VM_FETCH() \
+		UInt32 instruction = curCode[pc]; \
+		void* vm_handler = curHandlers[pc++]
+	#define VM_DISPATCH_BEGIN() \
+		if (!IsRunning) goto vm_dispatch_bottom; \
+		goto *vm_handler;
+	// Rewrite the current instruction's opcode (quickening) in both streams
+	#define VM_REWRITE(OP) do { \
+		curCode[pc-1] = BytecodeUtil::WithOP(instruction, Opcode::OP); \
+		curHandlers[pc-1] = vm_labels[(int)Opcode::OP]; } while (0)
+	// Switch to the handler array of function currentFuncIndex
+	#define VM_SET_HANDLERS() curHandlers = funcHandlers[currentFuncIndex]
+#else
+	#define VM_FETCH()      UInt32 instruction = curCode[pc++]
 	#define VM_DISPATCH_BEGIN() \
 		if (!IsRunning) goto vm_dispatch_bottom; \
 		goto *vm_labels[(int)opcode];
+	#define VM_REWRITE(OP)  curCode[pc-1] = BytecodeUtil::WithOP(instruction, Opcode::OP)
+	#define VM_SET_HANDLERS()
+#endif
 
 	#define VM_CASE(OP)     L_##OP:
 	#define VM_NEXT()       goto vm_dispatch_top
@@ -105,6 +181,9 @@
 	#define VM_DISPATCH_BOTTOM() vm_dispatch_bottom:
 #else
 	#define VM_DISPATCH_TOP() /* unused */
+	#define VM_FETCH()         UInt32 instruction = curCode[pc++]
+	#define VM_REWRITE(OP)     curCode[pc-1] = BytecodeUtil::WithOP(instruction, Opcode::OP)
+	#define VM_SET_HANDLERS()
 	#define VM_DISPATCH_BEGIN() \
 		switch (opcode) {
 	#define VM_CASE(OP)        case Opcode::OP:
@@ -113,6 +192,57 @@
 	#define VM_DISPATCH_BOTTOM()
 #endif
 
+#if VM_USE_TAIL_CALLS
+	#if defined(__has_attribute)
+	#  if __has_attribute(musttail)
+	#    define VM_MUSTTAIL __attribute__((musttail))
+	#  endif
+	#endif
+	#ifndef VM_MUSTTAIL
+	#  define VM_MUSTTAIL
+	#endif
+
+	// Arguments of every handler (besides the VM itself)
+	#define VM_TAIL_PARAMS \
+		Int32 pc, Value* localStack, Value* curConstants, UInt32* curCode, Int64 cyclesLeft
+	#define VM_TAIL_ARGS   pc, localStack, curConstants, curCode, cyclesLeft
+
+	// Handler declarations (in class VM), definitions, and the handler table
+	#define VM_TAIL_DECLARE(OP) private: Value Tail_##OP(VM_TAIL_PARAMS);
+	#define VM_TAIL_HANDLER(OP) Value VM::Tail_##OP(VM_TAIL_PARAMS)
+	#define VM_TAIL_LIST(OP)    &VM::Tail_##OP,
+
+	// Start of each handler: the rest of Run's locals, as the case body
+	// expects to find them.  Those a call or return changes are references
+	// to the VM's own fields, so that the change sticks.
+	#define VM_TAIL_PROLOGUE() \
+		UInt32 instruction = curCode[pc-1]; \
+		Int32& baseIndex = BaseIndex; \
+		Int32& currentFuncIndex = _currentFuncIndex; \
+		FuncDef*& curFunc = tailFunc; \
+		(void)instruction; (void)baseIndex; (void)currentFuncIndex; (void)curFunc; \
+		(void)localStack; (void)curConstants; (void)cyclesLeft
+
+	// End of each handler: on to the next one.  Anything out of the ordinary
+	// at the top of Run's loop (stopping, or stepping/tracing/profiling) is
+	// left to TailDispatch, so that the handlers themselves make no calls but
+	// this.  (As in Run, the cycle budget is checked only at safepoints.)
+	#undef VM_NEXT
+	#define VM_NEXT() do { \
+		if (!IsRunning || tailHooks) { \
+			VM_MUSTTAIL return TailDispatch(VM_TAIL_ARGS); \
+		} \
+		gc_alloc_site.pc = pc; \
+		UInt32 vm_op = BytecodeUtil::OP(curCode[pc++]); \
+		VM_MUSTTAIL return (this->*tailHandlers[vm_op])(VM_TAIL_ARGS); \
+	} while (0)
+
+	// A call or return switches to another register window
+	#undef VM_SET_HANDLERS
+	#define VM_SET_HANDLERS() localStack = tailStack + baseIndex
+#endif
+
 // Layer 0 foundation utility - safe to include from any layer
 // No layer violation checks needed (Layer 0 has no dependencies)
 
+#endif // DISPATCH_MACROS_H
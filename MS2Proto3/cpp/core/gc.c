@@ -1,13 +1,20 @@
+#define _POSIX_C_SOURCE 200112L  // for posix_memalign and clock_gettime
+#define _DEFAULT_SOURCE          // for madvise
+
 #include "gc.h"
+#include "gc_profile.h"
 #include "value.h"
 #include "value_string.h"
 #include "value_list.h"
 #include "value_map.h"
+#include "value_range.h"
 #include "StringStorage.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <sys/mman.h>
 
 #include "layer_defs.h"
 #if LAYER_2A_HIGHER
@@ -20,13 +27,100 @@
 // #define GC_DEBUG 1
 // #define GC_AGGRESSIVE 1  // Collect on every allocation (for testing)
 
-// GC Object header - minimal overhead
+// Small objects live in size-class pages: GC_PAGE_SIZE-aligned chunks of
+// memory, each carved into cells of a single size (header included).  The
+// size classes are powers of two, GC_MIN_CELL_SIZE up to GC_MAX_CELL_SIZE;
+// anything bigger gets its own malloc.
+#define GC_PAGE_SIZE (64 * 1024)             // Bytes per page (also its alignment)
+#define GC_SIZE_CLASS_COUNT 8
+#define GC_MIN_CELL_SIZE 16
+#define GC_MAX_CELL_SIZE (GC_MIN_CELL_SIZE << (GC_SIZE_CLASS_COUNT - 1))  // 2048
+#define GC_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+// Young generation ("nursery") budget: after this many bytes of new
+// allocation, we do a minor collection, which only looks at young objects.
+#define GC_NURSERY_SIZE (1024 * 1024)
+
+// Even if the heap stays under its threshold, do a major collection after
+// allocating this many thresholds' worth, so that garbage in the old space
+// (say, after a one-time spike) doesn't hold on to memory forever.
+#define GC_MAJOR_INTERVAL 4
+
+// Incremental mode (see gc_set_pause_budget): while a major collection is
+// in progress, we do one budgeted step of it per this many bytes allocated.
+#define GC_STEP_BYTES (64 * 1024)
+#define GC_STEP_CHECK_INTERVAL 64   // Objects marked between clock checks
+#define GC_PAUSE_HISTORY 256        // Pauses kept for gc_get_pause_histogram
+
+// GC Object header - minimal overhead.  Everything else we need to know
+// about a small object comes from its page: its size (the page's cell size)
+// and its mark bit (in the page's mark bitmap).  Large objects have a bigger
+// header in front of this one (see GCLargeObject).
 typedef struct GCObject {
-    struct GCObject* next;  // Linked list of all objects
-    bool marked;           // Mark bit for GC
-    size_t size;          // Size for sweep phase
+    uint8_t flags;         // GC_FLAG_* bits, below
+    uint8_t type;          // GCObjectType (for heap statistics only)
+    uint8_t reserved[6];   // (pads the header to 8 bytes, keeping the data aligned)
 } GCObject;
 
+#define GC_FLAG_OLD        0x01  // Survived a collection; lives in the old space
+#define GC_FLAG_LARGE      0x02  // Too big for a page; has its own malloc
+#define GC_FLAG_REMEMBERED 0x04  // Old object currently in the remembered set
+#define GC_FLAG_IMMORTAL   0x08  // Never collected (e.g. interned strings)
+#define GC_FLAG_FREE       0x10  // Page cell not currently in use
+#define GC_FLAG_GRAY       0x20  // Marked, but pushed again to be rescanned (see gc_write_barrier)
+#define GC_FLAG_MARKED     0x40  // Mark bit (large objects only; see GCPage.mark_bits)
+#define GC_FLAG_SAMPLED    0x80  // Being followed by the heap profiler (see gc_profile.h)
+
+// A free cell links to the next one through its first word of data
+#define GC_FREE_NEXT(obj) (*(GCObject**)((char*)(obj) + sizeof(GCObject)))
+
+// Large objects (too big for a page) are malloc'd with this in front
+typedef struct GCLargeObject {
+    struct GCLargeObject* next;  // Old or young large object list
+    size_t size;                 // Total size, this struct included
+    GCObject header;             // (the object data follows this)
+} GCLargeObject;
+
+#define GC_LARGE_OF(obj) ((GCLargeObject*)((char*)(obj) - offsetof(GCLargeObject, header)))
+
+// Page header; the cells follow it.  Cells below `top` have been handed out
+// at least once, and are either in use or on the free list; cells from `top`
+// to `limit` have never been used (so a fresh page is bump-allocated).
+// Mark bits live here, one per cell, rather than in the objects, so marking
+// doesn't write to every live object (which would also defeat copy-on-write
+// sharing of the heap after a fork).
+#define GC_PAGE_MARK_WORDS (GC_PAGE_SIZE / GC_MIN_CELL_SIZE / 64)
+
+typedef struct GCPage {
+    struct GCPage* next;        // All pages of this size class
+    struct GCPage* next_avail;  // Pages of this class with free cells
+    GCObject* free_list;        // Free cells below top (rebuilt by each sweep)
+    char* top;                  // Bump pointer: next never-used cell
+    char* limit;                // End of the last whole cell
+    int size_class;
+    int cell_size;
+    int cell_shift;             // log2(cell_size)
+    int live_count;             // Cells in use
+    int young_count;            // ...of which are young
+    bool needs_sweep;           // Not yet swept since the last (incremental) mark
+    uint64_t mark_bits[GC_PAGE_MARK_WORDS];  // Mark bit per cell
+} GCPage;
+
+#define GC_PAGE_FIRST_CELL(page) ((char*)(page) + GC_ALIGN(sizeof(GCPage)))
+#define GC_PAGE_OF(obj) ((GCPage*)((uintptr_t)(obj) & ~(uintptr_t)(GC_PAGE_SIZE - 1)))
+#define GC_CELL_INDEX(page, obj) ((int)(((char*)(obj) - GC_PAGE_FIRST_CELL(page)) >> (page)->cell_shift))
+
+// Default heap policy (see gc_set_heap_policy)
+#define GC_DEFAULT_TARGET_LIVE_RATIO 0.5
+#define GC_DEFAULT_SHRINK_RATE 0.5
+#define GC_DEFAULT_MIN_THRESHOLD (1024 * 1024)
+
+typedef struct GCSizeClass {
+    GCPage* pages;        // All pages of this class
+    GCPage* avail;        // Pages with free cells; we allocate from the first
+    GCPage** sweep_cursor; // Lazy sweep: link to the next page to look at (or NULL)
+} GCSizeClass;
+
 // Scope management for RAII-style protection
 typedef struct GCScope {
     int start_index;      // Where this scope starts in the root stack
@@ -39,16 +133,99 @@ typedef struct GCRootSet {
     int capacity;
 } GCRootSet;
 
+// Root ranges - arrays of Values owned by somebody else (see gc_add_root_range)
+typedef struct GCRootRange {
+    char* base;           // First item, or NULL if this slot is unused
+    int count;            // Item count (if no live_count function)
+    size_t stride;        // Bytes from one item to the next
+    GCLiveCountFunc live_count;
+    void* context;
+} GCRootRange;
+
+typedef struct GCRootRangeSet {
+    GCRootRange* ranges;
+    int count;            // Slots in use (including freed ones below the top)
+    int capacity;
+} GCRootRangeSet;
+
+// Root scan hooks (see gc_add_root_scan_hook)
+typedef struct GCRootScanHookEntry {
+    GCRootScanHook hook;  // Function to call, or NULL if this slot is unused
+    void* context;
+} GCRootScanHookEntry;
+
+typedef struct GCRootScanHookSet {
+    GCRootScanHookEntry* hooks;
+    int count;            // Slots in use (including freed ones below the top)
+    int capacity;
+} GCRootScanHookSet;
+
+// Gray stack - containers reached by the marker but not yet scanned.  Using
+// this instead of recursion keeps deep structures (say, a list nested 100k
+// deep) from overflowing the C stack, and lets incremental marking stop and
+// resume.
+typedef struct GCGrayStack {
+    Value* items;
+    int count;
+    int capacity;
+} GCGrayStack;
+
+// Phase of an incremental major collection
+typedef enum {
+    GC_PHASE_IDLE,        // No major collection in progress
+    GC_PHASE_MARK,        // Marking, a slice at a time
+    GC_PHASE_SWEEP        // Marking done; pages are being swept lazily
+} GCPhase;
+
+// Remembered set - old objects which may point to young ones
+typedef struct GCRememberedSet {
+    Value* items;         // Containers (lists/maps) recorded by the write barrier
+    int count;
+    int capacity;
+} GCRememberedSet;
+
 // GC state
 typedef struct GC {
-    GCObject* all_objects;    // Linked list of all allocated objects
+    GCLargeObject* all_objects; // Linked list of all old large objects
+    GCLargeObject* young_large; // Linked list of young large objects
+    GCSizeClass classes[GC_SIZE_CLASS_COUNT]; // Pages of small objects, by size class
+    int page_count;           // Total pages, all classes
+    GCPage* free_pages;       // Empty pages kept for reuse (memory released to the OS)
+    int free_page_count;
+    GCHeapPolicy policy;      // Heap sizing policy
+    GCRememberedSet remembered; // Old containers written since the last collection
+    bool minor_marking;       // True while marking for a minor collection
+    bool marks_stale;         // True if gc_mark_phase left marks set outside a collection
+    GCPhase phase;            // Incremental collection phase
+    GCGrayStack gray;         // Containers waiting to be scanned by the marker
+    unsigned int pause_budget_us; // Incremental step budget, or 0 for stop-the-world
+    unsigned int max_pause_us;    // Longest single GC pause so far
+    size_t step_bytes;        // Bytes allocated since the last incremental step
+    size_t cycle_bytes;       // bytes_allocated when incremental marking finished
+    int incremental_steps_count; // Number of incremental steps performed
     GCRootSet root_set;       // Stack of root values
+    GCRootRangeSet root_ranges; // Arrays of root values (e.g. VM registers)
+    GCRootScanHookSet scan_hooks; // Called before each root scan
     GCScope scope_stack[64];  // Stack of scopes for RAII-style protection
     int scope_count;          // Number of active scopes
-    size_t bytes_allocated;   // Total allocated memory
-    size_t gc_threshold;      // Trigger collection when exceeded
+    size_t bytes_allocated;   // Total allocated memory (young + old)
+    size_t young_bytes;       // Portion of the above allocated since the last collection
+    size_t gc_threshold;      // Trigger major collection when exceeded
     int disable_count;        // Counter for nested disable/enable calls
-    int collections_count;    // Number of collections performed
+    int collections_count;    // Number of (major) collections performed
+    int minor_collections_count; // Number of minor collections performed
+    int minors_since_major;   // Minor collections since the last major one
+    int emergency_collections_count; // Full collections forced by the heap limit
+    bool is_initialized;        // Set by gc_init
+    size_t bytes_freed_total;   // Bytes swept since gc_init (for telemetry)
+    size_t objects_marked_total; // Objects marked since gc_init (for telemetry)
+    GCCollectionRecord cycle;   // Collection in progress (times so far)
+    size_t cycle_freed_base;    // bytes_freed_total when it started
+    size_t cycle_marked_base;   // objects_marked_total when it started
+    GCCollectionRecord history[GC_HISTORY_SIZE]; // Ring of recent collections
+    int history_count;          // Total collections recorded
+    unsigned int pauses[GC_PAUSE_HISTORY]; // Ring of recent pauses (us)
+    int pause_count;            // Total pauses recorded
 } GC;
 
 // Global GC instance
@@ -58,33 +235,106 @@ GC gc = {0};
 void gc_mark_string(StringStorage* str);
 void gc_mark_list(ValueList* list);
 void gc_mark_map(ValueMap* map);
+static void gc_mark_list_items(ValueList* list);
+static void gc_mark_map_contents(ValueMap* map);
+static void gc_minor_collect(void);
+static void gc_start_cycle(void);
+static void gc_incremental_step(void);
+static void gc_finish_cycle(void);
+static bool gc_lazy_sweep_one(GCSizeClass* sc);
+static inline bool gc_is_marked(GCObject* obj);
 
 void gc_init(void) {
+    gc.is_initialized = true;
     gc.all_objects = NULL;
+    gc.young_large = NULL;
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        gc.classes[i].pages = NULL;
+        gc.classes[i].avail = NULL;
+        gc.classes[i].sweep_cursor = NULL;
+    }
+    gc.page_count = 0;
+    gc.free_pages = NULL;
+    gc.free_page_count = 0;
+    gc.policy.target_live_ratio = GC_DEFAULT_TARGET_LIVE_RATIO;
+    gc.policy.shrink_rate = GC_DEFAULT_SHRINK_RATE;
+    gc.policy.min_threshold = GC_DEFAULT_MIN_THRESHOLD;
+    gc.policy.max_heap = 0;
+    gc.policy.release_pages = true;
+    gc.remembered.items = malloc(sizeof(Value) * 64);
+    gc.remembered.count = 0;
+    gc.remembered.capacity = 64;
+    gc.minor_marking = false;
+    gc.marks_stale = false;
+    gc.phase = GC_PHASE_IDLE;
+    gc.gray.items = malloc(sizeof(Value) * 256);
+    gc.gray.count = 0;
+    gc.gray.capacity = 256;
+    gc.pause_budget_us = 0;
+    gc.max_pause_us = 0;
+    gc.bytes_freed_total = 0;
+    gc.objects_marked_total = 0;
+    gc.history_count = 0;
+    gc.pause_count = 0;
+    gc.step_bytes = 0;
+    gc.cycle_bytes = 0;
+    gc.incremental_steps_count = 0;
     gc.root_set.roots = malloc(sizeof(Value*) * 64);  // Array of Value* (shadow stack)
     gc.root_set.count = 0;
     gc.root_set.capacity = 64;
+    gc.root_ranges.ranges = malloc(sizeof(GCRootRange) * 8);
+    gc.root_ranges.count = 0;
+    gc.root_ranges.capacity = 8;
+    gc.scan_hooks.hooks = malloc(sizeof(GCRootScanHookEntry) * 4);
+    gc.scan_hooks.count = 0;
+    gc.scan_hooks.capacity = 4;
     gc.scope_count = 0;
     gc.bytes_allocated = 0;
-    gc.gc_threshold = 1024 * 1024;  // 1MB initial threshold
+    gc.young_bytes = 0;
+    gc.gc_threshold = gc.policy.min_threshold;
     gc.disable_count = 0;
     gc.collections_count = 0;
+    gc.minor_collections_count = 0;
+    gc.minors_since_major = 0;
+    gc.emergency_collections_count = 0;
+}
+
+static void gc_free_object_list(GCLargeObject* obj) {
+    while (obj) {
+        GCLargeObject* next = obj->next;
+        free(obj);
+        obj = next;
+    }
 }
 
 void gc_shutdown(void) {
     // Force final collection to clean up everything
     gc_collect();
+    gc_profile_stop();
     
-    // Free any remaining objects (shouldn't be any)
-    GCObject* obj = gc.all_objects;
-    while (obj) {
-        GCObject* next = obj->next;
-        free(obj);
-        obj = next;
+    // Free any remaining objects (shouldn't be any), and all pages
+    gc_free_object_list(gc.all_objects);
+    gc_free_object_list(gc.young_large);
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        GCPage* page = gc.classes[i].pages;
+        while (page) {
+            GCPage* next = page->next;
+            free(page);
+            page = next;
+        }
+    }
+    while (gc.free_pages) {
+        GCPage* next = gc.free_pages->next;
+        free(gc.free_pages);
+        gc.free_pages = next;
     }
     
-    // Free root set
+    // Free root set and remembered set
     free(gc.root_set.roots);
+    free(gc.root_ranges.ranges);
+    free(gc.scan_hooks.hooks);
+    free(gc.gray.items);
+    free(gc.remembered.items);
     memset(&gc, 0, sizeof(gc));
 }
 
@@ -103,6 +353,67 @@ void gc_unprotect_value(void) {
     gc.root_set.count--;
 }
 
+int gc_add_root_range(Value* base, int count, size_t stride,
+                      GCLiveCountFunc live_count, void* context) {
+    assert(gc.root_ranges.capacity > 0);	// if this fails, it means we forgot to call gc_init()
+
+    // Reuse a free slot if there is one; otherwise add to the end
+    int handle = 0;
+    while (handle < gc.root_ranges.count && gc.root_ranges.ranges[handle].base) handle++;
+    if (handle == gc.root_ranges.count) {
+        if (gc.root_ranges.count >= gc.root_ranges.capacity) {
+            gc.root_ranges.capacity *= 2;
+            gc.root_ranges.ranges = realloc(gc.root_ranges.ranges,
+                                            sizeof(GCRootRange) * gc.root_ranges.capacity);
+        }
+        gc.root_ranges.count++;
+    }
+
+    GCRootRange* range = &gc.root_ranges.ranges[handle];
+    range->base = (char*)base;
+    range->count = count;
+    range->stride = stride;
+    range->live_count = live_count;
+    range->context = context;
+    return handle;
+}
+
+void gc_remove_root_range(int handle) {
+    assert(handle >= 0 && handle < gc.root_ranges.count);
+    gc.root_ranges.ranges[handle].base = NULL;
+    while (gc.root_ranges.count > 0 && !gc.root_ranges.ranges[gc.root_ranges.count - 1].base) {
+        gc.root_ranges.count--;
+    }
+}
+
+int gc_add_root_scan_hook(GCRootScanHook hook, void* context) {
+    assert(gc.scan_hooks.capacity > 0);	// if this fails, it means we forgot to call gc_init()
+
+    // Reuse a free slot if there is one; otherwise add to the end
+    int handle = 0;
+    while (handle < gc.scan_hooks.count && gc.scan_hooks.hooks[handle].hook) handle++;
+    if (handle == gc.scan_hooks.count) {
+        if (gc.scan_hooks.count >= gc.scan_hooks.capacity) {
+            gc.scan_hooks.capacity *= 2;
+            gc.scan_hooks.hooks = realloc(gc.scan_hooks.hooks,
+                                          sizeof(GCRootScanHookEntry) * gc.scan_hooks.capacity);
+        }
+        gc.scan_hooks.count++;
+    }
+
+    gc.scan_hooks.hooks[handle].hook = hook;
+    gc.scan_hooks.hooks[handle].context = context;
+    return handle;
+}
+
+void gc_remove_root_scan_hook(int handle) {
+    assert(handle >= 0 && handle < gc.scan_hooks.count);
+    gc.scan_hooks.hooks[handle].hook = NULL;
+    while (gc.scan_hooks.count > 0 && !gc.scan_hooks.hooks[gc.scan_hooks.count - 1].hook) {
+        gc.scan_hooks.count--;
+    }
+}
+
 void gc_push_scope(void) {
 	assert(gc.root_set.capacity > 0);	// if this fails, it means we forgot to call gc_init()
     assert(gc.scope_count < 64);
@@ -128,56 +439,304 @@ void gc_enable(void) {
     gc.disable_count--;
 }
 
-void* gc_allocate(size_t size) {
-    // Trigger collection BEFORE allocation
-#ifdef GC_AGGRESSIVE
-    // Aggressive mode: collect on every allocation (for testing)
-    if (gc.disable_count == 0) {
+static void* gc_malloc_or_die(size_t size) {
+    void* p = malloc(size);
+    if (!p) {
+        // Try collecting garbage and retry
         gc_collect();
+        p = malloc(size);
+        if (!p) {
+            fprintf(stderr, "Out of memory!\n");
+            exit(1);
+        }
     }
-#else
-    // Normal mode: collect when threshold exceeded
-    if (gc.disable_count == 0 && gc.bytes_allocated > gc.gc_threshold) {
-        gc_collect();
+    return p;
+}
+
+// Find the size class for an object of the given total size (header
+// included), which must be <= GC_MAX_CELL_SIZE.
+static inline int gc_size_class(size_t total_size) {
+    int size_class = 0;
+    size_t cell_size = GC_MIN_CELL_SIZE;
+    while (cell_size < total_size) {
+        cell_size <<= 1;
+        size_class++;
     }
-#endif
-    
-    // Add space for GC header
-    size_t total_size = sizeof(GCObject) + size;
-    GCObject* obj = malloc(total_size);
-    
-    if (!obj) {
-        // Try collecting garbage and retry
+    return size_class;
+}
+
+static GCPage* gc_new_page(int size_class) {
+    void* mem = NULL;
+    if (gc.free_pages) {
+        // Reuse an empty page (the OS gives it fresh memory as we touch it)
+        mem = gc.free_pages;
+        gc.free_pages = gc.free_pages->next;
+        gc.free_page_count--;
+    } else if (posix_memalign(&mem, GC_PAGE_SIZE, GC_PAGE_SIZE) != 0) {
         gc_collect();
-        obj = malloc(total_size);
-        if (!obj) {
+        if (posix_memalign(&mem, GC_PAGE_SIZE, GC_PAGE_SIZE) != 0) {
             fprintf(stderr, "Out of memory!\n");
             exit(1);
         }
     }
-    
-    // Initialize GC header
-    obj->next = gc.all_objects;
-    obj->marked = false;
-    obj->size = total_size;
-    gc.all_objects = obj;
+    GCPage* page = (GCPage*)mem;
+    int cell_size = GC_MIN_CELL_SIZE << size_class;
+    int cell_count = (int)((GC_PAGE_SIZE - GC_ALIGN(sizeof(GCPage))) / cell_size);
+    page->free_list = NULL;
+    page->top = GC_PAGE_FIRST_CELL(page);
+    page->limit = page->top + cell_count * cell_size;
+    page->size_class = size_class;
+    page->cell_size = cell_size;
+    page->cell_shift = 4 + size_class;  // (GC_MIN_CELL_SIZE is 16)
+    page->live_count = 0;
+    page->young_count = 0;
+    page->needs_sweep = false;
+    memset(page->mark_bits, 0, sizeof(page->mark_bits));
+
+    GCSizeClass* sc = &gc.classes[size_class];
+    page->next = sc->pages;
+    sc->pages = page;
+    page->next_avail = sc->avail;
+    sc->avail = page;
+    gc.page_count++;
+    return page;
+}
+
+// Give back a page that has become empty.  If the policy allows, we keep
+// the page (so its address range can be reused), but tell the OS it may
+// reclaim the memory; otherwise it goes back to malloc.
+static void gc_release_page(GCPage* page) {
+    gc.page_count--;
+#ifdef MADV_DONTNEED
+    if (gc.policy.release_pages) {
+        // (keep the first OS page, which holds the link to the next one)
+        size_t keep = 4096;
+        madvise((char*)page + keep, GC_PAGE_SIZE - keep, MADV_DONTNEED);
+        page->next = gc.free_pages;
+        gc.free_pages = page;
+        gc.free_page_count++;
+        return;
+    }
+#endif
+    free(page);
+}
+
+// Take a cell of the given size class: from a free list if possible, else
+// from the never-used part of a page (getting a new page if we must).
+static GCObject* gc_take_cell(int size_class) {
+    GCSizeClass* sc = &gc.classes[size_class];
+    for (;;) {
+        GCPage* page = sc->avail;
+        if (!page) {
+            // Mid-way through a lazy sweep, sweep more of our pages before growing
+            if (gc.phase == GC_PHASE_SWEEP && gc_lazy_sweep_one(sc)) continue;
+            page = gc_new_page(size_class);
+        }
+        GCObject* obj = page->free_list;
+        if (obj) {
+            page->free_list = GC_FREE_NEXT(obj);
+        } else if (page->top < page->limit) {
+            obj = (GCObject*)page->top;
+            page->top += page->cell_size;
+        } else {
+            sc->avail = page->next_avail;  // page is full; move on
+            continue;
+        }
+        page->live_count++;
+        page->young_count++;
+        return obj;
+    }
+}
+
+// We're about to exceed the hard heap limit: do a full collection, right
+// now, and if that doesn't make enough room, give up.
+static void gc_emergency_collect(size_t total_size) {
+    if (gc.disable_count > 0) return;  // (can't collect now; let it through)
+    gc.emergency_collections_count++;
+    gc_collect();
+    if (gc.bytes_allocated + total_size > gc.policy.max_heap) {
+        fprintf(stderr, "Out of memory! (heap limit of %zu bytes exceeded)\n", gc.policy.max_heap);
+        exit(1);
+    }
+}
+
+void* gc_allocate(size_t size, GCObjectType type) {
+    if (!gc.is_initialized) return gc_allocate_immortal(size);
+    size_t total_size = GC_ALIGN(sizeof(GCObject) + size);
+
+    if (gc.policy.max_heap && gc.bytes_allocated + total_size > gc.policy.max_heap) {
+        gc_emergency_collect(total_size);
+    }
+
+    // Trigger collection BEFORE allocation
+#ifdef GC_AGGRESSIVE
+    // Aggressive mode: collect on every allocation (for testing); mostly
+    // minor collections, with a full collection every so often
+    // (or in incremental mode, an incremental step most of the time)
+    static int aggressive_count = 0;
+    if (gc.disable_count == 0) {
+        if (gc.phase != GC_PHASE_IDLE) gc_incremental_step();
+        else if (++aggressive_count % 8 != 0) gc_minor_collect();
+        else if (gc.pause_budget_us > 0) gc_start_cycle();
+        else gc_collect();
+    }
+#else
+    // Normal mode: collect when the nursery is full (a full collection if
+    // the whole heap has also outgrown its threshold).  In incremental mode,
+    // a major collection instead proceeds a step at a time as we allocate.
+    if (gc.disable_count == 0) {
+        if (gc.phase != GC_PHASE_IDLE) {
+            gc.step_bytes += total_size;
+            if (gc.step_bytes >= GC_STEP_BYTES) gc_incremental_step();
+        } else if (gc.young_bytes + total_size > GC_NURSERY_SIZE) {
+            bool major_due = gc.bytes_allocated > gc.gc_threshold
+                || (size_t)gc.minors_since_major * GC_NURSERY_SIZE > gc.gc_threshold * GC_MAJOR_INTERVAL;
+            if (!major_due) gc_minor_collect();
+            else if (gc.pause_budget_us > 0) gc_start_cycle();
+            else gc_collect();
+        }
+    }
+#endif
+
+    GCObject* obj;
+    if (total_size <= GC_MAX_CELL_SIZE) {
+        // Common case: a cell from a size-class page
+        int size_class = gc_size_class(total_size);
+        obj = gc_take_cell(size_class);
+        obj->flags = 0;
+        obj->type = (uint8_t)type;
+        total_size = GC_MIN_CELL_SIZE << size_class;
+    } else {
+        // Large object: malloc it by itself
+        total_size = GC_ALIGN(sizeof(GCLargeObject) + size);
+        GCLargeObject* large = gc_malloc_or_die(total_size);
+        large->next = gc.young_large;
+        large->size = total_size;
+        gc.young_large = large;
+        obj = &large->header;
+        obj->flags = GC_FLAG_LARGE;
+        obj->type = (uint8_t)type;
+    }
     
     gc.bytes_allocated += total_size;
+    gc.young_bytes += total_size;
+
+    // Heap profiler: sample an object every so many bytes
+    gc_profile_bytes_left -= (long)total_size;
+    if (gc_profile_bytes_left <= 0 && gc_profile_sample(obj, total_size)) {
+        obj->flags |= GC_FLAG_SAMPLED;
+    }
     
     // Return pointer to data area (after header)
     return (char*)obj + sizeof(GCObject);
 }
 
+void* gc_allocate_immortal(size_t size) {
+    // Allocated with a header (so the marker can recognize it), but not in
+    // a page or any list, so it is never swept (nor marked).
+    GCObject* obj = gc_malloc_or_die(sizeof(GCObject) + size);
+    obj->flags = GC_FLAG_OLD | GC_FLAG_IMMORTAL;
+    obj->type = GC_TYPE_OTHER;
+    return (char*)obj + sizeof(GCObject);
+}
+
+// Push a container onto the gray stack, to be marked and scanned when popped.
+// We don't look at it now, but ask for its header to be fetched into the
+// cache, so it's (hopefully) there by the time we do.
+#if defined(__GNUC__) || defined(__clang__)
+#define GC_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define GC_PREFETCH(addr) ((void)0)
+#endif
+
+static inline void gc_push_gray(Value container) {
+    GC_PREFETCH((char*)(uintptr_t)(container & 0xFFFFFFFFFFFFULL) - sizeof(GCObject));
+    if (gc.gray.count >= gc.gray.capacity) {
+        gc.gray.capacity *= 2;
+        gc.gray.items = realloc(gc.gray.items, sizeof(Value) * gc.gray.capacity);
+    }
+    gc.gray.items[gc.gray.count++] = container;
+}
+
+void gc_write_barrier(Value container) {
+    GCObject* obj = (GCObject*)((char*)(uintptr_t)(container & 0xFFFFFFFFFFFFULL) - sizeof(GCObject));
+    if (obj->flags & GC_FLAG_IMMORTAL) return;
+
+    // During incremental marking, a container that has already been scanned
+    // (black) may now point to something unmarked; make it gray again, so
+    // it gets rescanned.
+    if (gc.phase == GC_PHASE_MARK && !(obj->flags & GC_FLAG_GRAY) && gc_is_marked(obj)) {
+        obj->flags |= GC_FLAG_GRAY;
+        gc_push_gray(container);
+    }
+
+    // Only old objects need remembering (and only once per collection cycle).
+    // While lazily sweeping, marked objects count as old: they will be by the
+    // time the sweep reaches them.
+    bool old = (obj->flags & GC_FLAG_OLD) || (gc.phase == GC_PHASE_SWEEP && gc_is_marked(obj));
+    if (!old || (obj->flags & GC_FLAG_REMEMBERED)) return;
+    obj->flags |= GC_FLAG_REMEMBERED;
+
+    if (gc.remembered.count >= gc.remembered.capacity) {
+        gc.remembered.capacity *= 2;
+        gc.remembered.items = realloc(gc.remembered.items,
+                                      sizeof(Value) * gc.remembered.capacity);
+    }
+    gc.remembered.items[gc.remembered.count++] = container;
+}
+
+static unsigned long gc_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + (unsigned long)(ts.tv_nsec / 1000);
+}
+
+static inline bool gc_is_marked(GCObject* obj) {
+    if (obj->flags & GC_FLAG_LARGE) return (obj->flags & GC_FLAG_MARKED) != 0;
+    if (obj->flags & GC_FLAG_IMMORTAL) return false;
+    GCPage* page = GC_PAGE_OF(obj);
+    int i = GC_CELL_INDEX(page, obj);
+    return (page->mark_bits[i >> 6] >> (i & 63)) & 1;
+}
+
+bool gc_is_dying(void* ptr) {
+    if (gc.phase != GC_PHASE_SWEEP) return false;
+    GCObject* obj = (GCObject*)ptr - 1;
+    if (obj->flags & (GC_FLAG_LARGE | GC_FLAG_IMMORTAL)) return false;  // (large ones are swept already)
+    return GC_PAGE_OF(obj)->needs_sweep && !gc_is_marked(obj);
+}
+
+// Set the mark on the given object, if it's one we should be marking in
+// the current collection.  Returns true if newly marked (caller should
+// then mark its children), false if it was already marked or is exempt.
+static inline bool gc_try_mark(GCObject* obj) {
+    uint8_t flags = obj->flags;
+    if (flags & GC_FLAG_IMMORTAL) return false;
+    if (gc.minor_marking && (flags & GC_FLAG_OLD)) return false;  // old space is not traced in a minor GC
+    if (flags & GC_FLAG_LARGE) {
+        if (flags & GC_FLAG_MARKED) return false;
+        obj->flags = flags | GC_FLAG_MARKED;
+        gc.objects_marked_total++;
+        return true;
+    }
+    GCPage* page = GC_PAGE_OF(obj);
+    int i = GC_CELL_INDEX(page, obj);
+    uint64_t bit = (uint64_t)1 << (i & 63);
+    if (page->mark_bits[i >> 6] & bit) return false;
+    page->mark_bits[i >> 6] |= bit;
+    gc.objects_marked_total++;
+    return true;
+}
+
 void gc_mark_value(Value v) {
     if (is_string(v)) {
         StringStorage* str = as_string(v);
         if (str) gc_mark_string(str);
-    } else if (is_list(v)) {
-        ValueList* list = as_list(v);
-        if (list) gc_mark_list(list);
-    } else if (is_map(v)) {
-        ValueMap* map = as_map(v);
-        if (map) gc_mark_map(map);
+    } else if (is_list(v) || is_map(v) || is_funcref(v) || is_range(v)) {
+        // Containers are marked when popped off the gray stack (and then
+        // their contents are pushed in turn).  A range counts as one, since
+        // it may refer to the list it has become.
+        if (v & 0xFFFFFFFFFFFFULL) gc_push_gray(v);
     }
     // Numbers, ints, nil don't need marking
 }
@@ -188,22 +747,15 @@ void gc_mark_string(StringStorage* str) {
     // Get GC object header (it's right before the String data)
     GCObject* obj = (GCObject*)((char*)str - sizeof(GCObject));
     
-    if (!obj->marked) {
-        obj->marked = true;
-    }
+    gc_try_mark(obj);
     // Strings don't contain other Values, so we're done
 }
 
 void gc_mark_list(ValueList* list) {
-    if (!list) return;
-
-    // Get GC object header
-    GCObject* obj = (GCObject*)((char*)list - sizeof(GCObject));
-
-    if (obj->marked) return;  // Already marked
-
-    obj->marked = true;
+    if (list) gc_push_gray(LIST_TAG | ((uintptr_t)list & 0xFFFFFFFFFFFFULL));
+}
 
+static void gc_mark_list_items(ValueList* list) {
     // Mark all items in the list
     for (int i = 0; i < list->count; i++) {
         gc_mark_value(list->items[i]);
@@ -211,21 +763,14 @@ void gc_mark_list(ValueList* list) {
 }
 
 void gc_mark_map(ValueMap* map) {
-    if (!map) return;
-
-    // Get GC object header for the ValueMap structure
-    GCObject* map_obj = (GCObject*)((char*)map - sizeof(GCObject));
-
-    if (map_obj->marked) return;  // Already marked
-
-    map_obj->marked = true;
+    if (map) gc_push_gray(MAP_TAG | ((uintptr_t)map & 0xFFFFFFFFFFFFULL));
+}
 
+static void gc_mark_map_contents(ValueMap* map) {
     // Mark the entries array (if it exists)
     if (map->entries) {
         GCObject* entries_obj = (GCObject*)((char*)map->entries - sizeof(GCObject));
-        if (!entries_obj->marked) {
-            entries_obj->marked = true;
-        }
+        gc_try_mark(entries_obj);
 
         // Mark all keys and values in the map
         for (int i = 0; i < map->capacity; i++) {
@@ -235,10 +780,59 @@ void gc_mark_map(ValueMap* map) {
             }
         }
     }
+
+    // Mark the VarMap data (if any); the registers themselves belong to the VM
+    VarMapData* vdata = map->varmap_data;
+    if (vdata) {
+        gc_try_mark((GCObject*)((char*)vdata - sizeof(GCObject)));
+        if (vdata->reg_map_keys) {
+            gc_try_mark((GCObject*)((char*)vdata->reg_map_keys - sizeof(GCObject)));
+            for (int i = 0; i < vdata->reg_map_count; i++) {
+                gc_mark_value(vdata->reg_map_keys[i]);
+            }
+        }
+        if (vdata->reg_map_indices) {
+            gc_try_mark((GCObject*)((char*)vdata->reg_map_indices - sizeof(GCObject)));
+        }
+    }
 }
 
-void gc_mark_phase(void) {
-    // Mark all objects reachable from roots (shadow stack)
+// Pop containers off the gray stack, marking each one and pushing what it
+// refers to, until the stack is empty or the deadline passes (if not 0).
+// Returns true if it's empty.
+static bool gc_drain_gray(unsigned long deadline_us) {
+    int scanned = 0;
+    while (gc.gray.count > 0) {
+        if (deadline_us && ++scanned % GC_STEP_CHECK_INTERVAL == 0
+                && gc_now_us() >= deadline_us) return false;
+        Value v = gc.gray.items[--gc.gray.count];
+        GCObject* obj = (GCObject*)((char*)(uintptr_t)(v & 0xFFFFFFFFFFFFULL) - sizeof(GCObject));
+        if (obj->flags & GC_FLAG_GRAY) {
+            obj->flags &= ~GC_FLAG_GRAY;  // (already marked; just rescan it)
+        } else if (!gc_try_mark(obj)) {
+            continue;  // Already marked (or not ours to mark)
+        }
+        if (is_list(v)) {
+            gc_mark_list_items(as_list(v));
+        } else if (is_map(v)) {
+            gc_mark_map_contents(as_map(v));
+        } else if (is_range(v)) {
+            gc_mark_value(as_range(v)->list);
+        } else {
+            gc_mark_value(as_funcref(v)->outerVars);
+        }
+    }
+    return true;
+}
+
+static void gc_mark_roots(void) {
+    // Mark all objects reachable from roots (shadow stack).  Containers are
+    // just pushed onto the gray stack, for the caller to drain.
+    for (int i = 0; i < gc.scan_hooks.count; i++) {
+        GCRootScanHookEntry* entry = &gc.scan_hooks.hooks[i];
+        if (entry->hook) entry->hook(entry->context);
+    }
+
     for (int i = 0; i < gc.root_set.count; i++) {
         Value* root_ptr = gc.root_set.roots[i];
         if (root_ptr) {
@@ -246,26 +840,175 @@ void gc_mark_phase(void) {
             gc_mark_value(root);
         }
     }
+
+    // ...and from the root ranges
+    for (int i = 0; i < gc.root_ranges.count; i++) {
+        GCRootRange* range = &gc.root_ranges.ranges[i];
+        if (!range->base) continue;
+        int count = range->live_count ? range->live_count(range->context) : range->count;
+        char* p = range->base;
+        for (int j = 0; j < count; j++, p += range->stride) {
+            gc_mark_value(*(Value*)p);
+        }
+    }
     
-    // Note: Interned strings are allocated with malloc() and are immortal,
-    // so they don't need to be marked during GC
+    // Note: the intern table is not a root; it holds its strings weakly, and
+    // sweeping an interned string takes it out of the table (see unintern_string)
+}
+
+static void gc_clear_marks(void) {
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        for (GCPage* page = gc.classes[i].pages; page; page = page->next) {
+            memset(page->mark_bits, 0, sizeof(page->mark_bits));
+        }
+    }
+    for (GCLargeObject* obj = gc.all_objects; obj; obj = obj->next) obj->header.flags &= ~GC_FLAG_MARKED;
+    for (GCLargeObject* obj = gc.young_large; obj; obj = obj->next) obj->header.flags &= ~GC_FLAG_MARKED;
+    gc.marks_stale = false;
+}
+
+void gc_mark_phase(void) {
+    // Full mark from the roots, outside of any collection (for debugging).
+    // The marks stay set until the next collection clears them.
+    if (gc.phase != GC_PHASE_IDLE) gc_finish_cycle();
+    if (gc.marks_stale) gc_clear_marks();
+    gc_mark_roots();
+    gc_drain_gray(0);
+    gc.marks_stale = true;
+}
+
+// In a minor collection, old containers written since the last collection
+// act as additional roots: anything young they point to must survive.
+static void gc_mark_remembered(void) {
+    for (int i = 0; i < gc.remembered.count; i++) {
+        Value container = gc.remembered.items[i];
+        if (is_list(container)) {
+            gc_mark_list_items(as_list(container));
+        } else if (is_map(container)) {
+            gc_mark_map_contents(as_map(container));
+        } else if (is_range(container)) {
+            gc_mark_value(as_range(container)->list);
+        }
+    }
+}
+
+static void gc_clear_remembered(void) {
+    for (int i = 0; i < gc.remembered.count; i++) {
+        Value container = gc.remembered.items[i];
+        GCObject* obj = (GCObject*)((char*)(uintptr_t)(container & 0xFFFFFFFFFFFFULL) - sizeof(GCObject));
+        obj->flags &= ~GC_FLAG_REMEMBERED;
+    }
+    gc.remembered.count = 0;
+}
+
+// Sweep one page, rebuilding its free list as we go (in address order),
+// then clear its mark bits for next time.  In a minor collection only young
+// cells are considered: survivors become old, and the rest are freed.  Old
+// cells are left alone (not even marked).
+static void gc_sweep_page(GCPage* page, bool minor) {
+    GCObject* free_list = NULL;
+    GCObject** free_tail = &free_list;
+    int i = 0;
+    for (char* p = GC_PAGE_FIRST_CELL(page); p < page->top; p += page->cell_size, i++) {
+        GCObject* obj = (GCObject*)p;
+        if (!(obj->flags & GC_FLAG_FREE)) {
+            bool old = (obj->flags & GC_FLAG_OLD) != 0;
+            if (minor && old) continue;
+            if ((page->mark_bits[i >> 6] >> (i & 63)) & 1) {
+                // Live: promote if young
+                if (!old) {
+                    obj->flags |= GC_FLAG_OLD;
+                    page->young_count--;
+                }
+                continue;
+            }
+            // Garbage: free the cell
+            if (!old) page->young_count--;
+            page->live_count--;
+            gc.bytes_allocated -= page->cell_size;
+            gc.bytes_freed_total += page->cell_size;
+            if (obj->flags & GC_FLAG_SAMPLED) gc_profile_freed(obj);
+            if (obj->type == GC_TYPE_INTERNED_STRING) unintern_string((StringStorage*)(obj + 1));
+#ifdef GC_DEBUG
+            // Overwrite the object with garbage to catch stale pointer usage
+            memset(obj, 0xDEADBEEF, page->cell_size);
+#endif
+            obj->flags = GC_FLAG_FREE;
+        }
+        *free_tail = obj;
+        free_tail = &GC_FREE_NEXT(obj);
+    }
+    *free_tail = NULL;
+    page->free_list = free_list;
+    memset(page->mark_bits, 0, sizeof(page->mark_bits));
+}
+
+// Sweep the pages of every size class (in a minor collection, only those
+// holding young objects), rebuild the lists of pages with free cells, and
+// give pages that are now completely empty back to the system.
+static void gc_sweep_pages(bool minor) {
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        GCSizeClass* sc = &gc.classes[i];
+        GCPage** page_ptr = &sc->pages;
+        GCPage** avail_tail = &sc->avail;
+        while (*page_ptr) {
+            GCPage* page = *page_ptr;
+            if (!minor || page->young_count > 0) gc_sweep_page(page, minor);
+            if (page->live_count == 0) {
+                *page_ptr = page->next;
+                gc_release_page(page);
+                continue;
+            }
+            if (page->free_list || page->top < page->limit) {
+                *avail_tail = page;
+                avail_tail = &page->next_avail;
+            }
+            page_ptr = &page->next;
+        }
+        *avail_tail = NULL;
+    }
+}
+
+// Sweep the young large objects: survivors are promoted to the old list.
+static void gc_sweep_young_large(void) {
+    GCLargeObject* obj = gc.young_large;
+    while (obj) {
+        GCLargeObject* next = obj->next;
+        if (obj->header.flags & GC_FLAG_MARKED) {
+            obj->header.flags = (obj->header.flags & ~GC_FLAG_MARKED) | GC_FLAG_OLD;
+            obj->next = gc.all_objects;
+            gc.all_objects = obj;
+        } else {
+            gc.bytes_allocated -= obj->size;
+            gc.bytes_freed_total += obj->size;
+            if (obj->header.flags & GC_FLAG_SAMPLED) gc_profile_freed(&obj->header);
+#ifdef GC_DEBUG
+            memset(obj, 0xDEADBEEF, obj->size);
+#endif
+            free(obj);
+        }
+        obj = next;
+    }
+    gc.young_large = NULL;
 }
 
+// Sweep the old large objects.
 static void gc_sweep_phase(void) {
-    GCObject** obj_ptr = &gc.all_objects;
+    GCLargeObject** obj_ptr = &gc.all_objects;
     
     while (*obj_ptr) {
-        GCObject* obj = *obj_ptr;
+        GCLargeObject* obj = *obj_ptr;
         
-        if (obj->marked) {
+        if (obj->header.flags & GC_FLAG_MARKED) {
             // Object is live, clear mark for next collection
-            obj->marked = false;
+            obj->header.flags &= ~GC_FLAG_MARKED;
             obj_ptr = &obj->next;
         } else {
             // Object is garbage, remove from list and free
             *obj_ptr = obj->next;
             gc.bytes_allocated -= obj->size;
-            
+            gc.bytes_freed_total += obj->size;
+            if (obj->header.flags & GC_FLAG_SAMPLED) gc_profile_freed(&obj->header);
 #ifdef GC_DEBUG
             // Overwrite the object with garbage to catch stale pointer usage
             memset(obj, 0xDEADBEEF, obj->size);
@@ -275,27 +1018,272 @@ static void gc_sweep_phase(void) {
     }
 }
 
+//--------------------------------------------------------------------------
+// Telemetry: every pause goes into a ring (for gc_get_pause_histogram), and
+// each collection gets a record when it ends (for gc_get_collection_history).
+
+static void gc_note_pause(unsigned long start_us) {
+    unsigned long pause = gc_now_us() - start_us;
+    if (pause > gc.max_pause_us) gc.max_pause_us = (unsigned int)pause;
+    gc.pauses[gc.pause_count++ % GC_PAUSE_HISTORY] = (unsigned int)pause;
+}
+
+static void gc_begin_record(GCCollectionKind kind) {
+    gc.cycle.kind = kind;
+    gc.cycle.mark_us = 0;
+    gc.cycle.sweep_us = 0;
+    gc.cycle_freed_base = gc.bytes_freed_total;
+    gc.cycle_marked_base = gc.objects_marked_total;
+}
+
+static void gc_end_record(void) {
+    gc.cycle.bytes_freed = gc.bytes_freed_total - gc.cycle_freed_base;
+    gc.cycle.bytes_after = gc.bytes_allocated;
+    gc.cycle.objects_marked = gc.objects_marked_total - gc.cycle_marked_base;
+    gc.history[gc.history_count++ % GC_HISTORY_SIZE] = gc.cycle;
+    gc_profile_collection_done();
+}
+
+// Minor collection: mark only young objects (reachable from the roots or
+// from remembered old objects), then promote the survivors.
+static void gc_minor_collect(void) {
+    if (gc.disable_count > 0) return;
+    if (gc.phase == GC_PHASE_MARK) return;  // (the major collection will get it)
+    if (gc.phase == GC_PHASE_SWEEP) gc_finish_cycle();
+
+    unsigned long start = gc_now_us();
+    gc.minor_collections_count++;
+    gc.minors_since_major++;
+    gc_begin_record(GC_COLLECTION_MINOR);
+#ifdef GC_DEBUG
+    size_t before = gc.bytes_allocated;
+#endif
+
+    if (gc.marks_stale) gc_clear_marks();
+    gc.minor_marking = true;
+    gc_mark_roots();
+    gc_mark_remembered();
+    gc_drain_gray(0);
+    gc.minor_marking = false;
+    unsigned long marked = gc_now_us();
+    gc_clear_remembered();
+    gc_sweep_pages(true);
+    gc_sweep_young_large();
+    gc.young_bytes = 0;
+
+    gc.cycle.mark_us = (unsigned int)(marked - start);
+    gc.cycle.sweep_us = (unsigned int)(gc_now_us() - marked);
+    gc_end_record();
+    gc_note_pause(start);
+
+#ifdef GC_DEBUG
+    printf("GC (minor): freed %zu bytes, %zu bytes remaining\n",
+           before - gc.bytes_allocated, gc.bytes_allocated);
+#endif
+}
+
+//--------------------------------------------------------------------------
+// Incremental major collection (when a pause budget is set).  Marking is
+// tri-color: white objects are unmarked; gray objects sit on the gray stack,
+// waiting to be scanned; black objects are marked and fully scanned.  Each
+// step scans gray objects until the budget runs out.  The write barrier turns
+// a black container gray again when it is stored into, so nothing reachable
+// can be left white when the gray stack finally empties.  Then the roots are
+// scanned again (they are not covered by the barrier), and marking ends.
+// Pages are then swept lazily: a bit per step, and on demand when a size
+// class runs out of free cells.
+
+static void gc_start_cycle(void) {
+    unsigned long start = gc_now_us();
+    gc.collections_count++;
+    gc.minors_since_major = 0;
+    gc_begin_record(GC_COLLECTION_INCREMENTAL);
+    if (gc.marks_stale) gc_clear_marks();
+    gc.phase = GC_PHASE_MARK;
+    gc.step_bytes = 0;
+    gc_mark_roots();  // (just pushes them onto the gray stack)
+    gc.cycle.mark_us += (unsigned int)(gc_now_us() - start);
+    gc_note_pause(start);
+}
+
+// Finish marking: rescan the roots and mark everything still gray, then
+// sweep the large objects, and set up the lazy sweep of the pages.
+static void gc_finish_marking(void) {
+    gc_mark_roots();
+    gc_drain_gray(0);
+    gc_clear_remembered();
+    gc_sweep_phase();
+    gc_sweep_young_large();
+    gc.young_bytes = 0;
+    gc.cycle_bytes = gc.bytes_allocated;
+
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        GCSizeClass* sc = &gc.classes[i];
+        for (GCPage* page = sc->pages; page; page = page->next) page->needs_sweep = true;
+        sc->avail = NULL;
+        sc->sweep_cursor = &sc->pages;
+    }
+    gc.phase = GC_PHASE_SWEEP;
+}
+
+// Sweep the next unswept page of the given size class, making it available
+// for allocation (or freeing it, if it's now empty).  Returns false if there
+// were no pages left to sweep.
+static bool gc_lazy_sweep_one(GCSizeClass* sc) {
+    GCPage** page_ptr = sc->sweep_cursor;
+    if (!page_ptr) return false;
+    while (*page_ptr && !(*page_ptr)->needs_sweep) page_ptr = &(*page_ptr)->next;
+    GCPage* page = *page_ptr;
+    if (!page) {
+        sc->sweep_cursor = NULL;
+        return false;
+    }
+    gc_sweep_page(page, false);
+    page->needs_sweep = false;
+    if (page->live_count == 0) {
+        *page_ptr = page->next;
+        gc_release_page(page);
+    } else {
+        if (page->free_list || page->top < page->limit) {
+            page->next_avail = sc->avail;
+            sc->avail = page;
+        }
+        page_ptr = &page->next;
+    }
+    sc->sweep_cursor = page_ptr;
+    return true;
+}
+
+// After a major collection, set the threshold for the next one from what
+// survived: grow it at once to give the live data the target ratio, but
+// shrink it only gradually (so one quiet collection after a spike doesn't
+// immediately cause a burst of collections).  Never go below the minimum,
+// nor above the heap limit.
+static void gc_adjust_threshold(void) {
+    GCHeapPolicy* policy = &gc.policy;
+    size_t target = (size_t)(gc.bytes_allocated / policy->target_live_ratio);
+    if (target < policy->min_threshold) target = policy->min_threshold;
+    if (target >= gc.gc_threshold) {
+        gc.gc_threshold = target;
+    } else {
+        gc.gc_threshold -= (size_t)((gc.gc_threshold - target) * policy->shrink_rate);
+    }
+    if (policy->max_heap && gc.gc_threshold > policy->max_heap) gc.gc_threshold = policy->max_heap;
+}
+
+// Sweep pages until they're all swept (ending the cycle), or the deadline
+// passes (if not 0).
+static void gc_lazy_sweep(unsigned long deadline_us) {
+    unsigned long start = gc_now_us();
+    for (int i = 0; i < GC_SIZE_CLASS_COUNT; i++) {
+        while (gc_lazy_sweep_one(&gc.classes[i])) {
+            unsigned long now = gc_now_us();
+            if (deadline_us && now >= deadline_us) {
+                gc.cycle.sweep_us += (unsigned int)(now - start);
+                return;
+            }
+        }
+    }
+
+    // All done; adjust threshold based on how much survived
+    gc.phase = GC_PHASE_IDLE;
+    gc_adjust_threshold();
+    gc.cycle.sweep_us += (unsigned int)(gc_now_us() - start);
+    gc_end_record();
+#ifdef GC_DEBUG
+    size_t freed = gc.cycle_bytes + gc.young_bytes - gc.bytes_allocated;
+    printf("GC (incremental): freed %zu bytes, %zu bytes remaining, threshold now %zu\n",
+           freed, gc.bytes_allocated, gc.gc_threshold);
+#endif
+}
+
+// Do one budgeted step of the collection in progress.
+static void gc_incremental_step(void) {
+    unsigned long start = gc_now_us();
+    unsigned long deadline = start + gc.pause_budget_us;
+    gc.step_bytes = 0;
+    gc.incremental_steps_count++;
+
+    if (gc.phase == GC_PHASE_MARK) {
+        // Don't let a program that allocates faster than we mark outrun us
+        // forever: past twice the threshold, just finish marking.
+        bool overdue = gc.bytes_allocated > gc.gc_threshold * 2;
+        bool done = gc_drain_gray(overdue ? 0 : deadline);
+        if (done) gc_finish_marking();
+        gc.cycle.mark_us += (unsigned int)(gc_now_us() - start);
+        if (!done) {
+            gc_note_pause(start);
+            return;
+        }
+    }
+    if (gc.phase == GC_PHASE_SWEEP) gc_lazy_sweep(deadline);
+    gc_note_pause(start);
+}
+
+// Finish the collection in progress, all at once.
+static void gc_finish_cycle(void) {
+    unsigned long start = gc_now_us();
+    if (gc.phase == GC_PHASE_MARK) {
+        gc_drain_gray(0);
+        gc_finish_marking();
+        gc.cycle.mark_us += (unsigned int)(gc_now_us() - start);
+    }
+    if (gc.phase == GC_PHASE_SWEEP) gc_lazy_sweep(0);
+    gc_note_pause(start);
+}
+
+void gc_set_pause_budget(unsigned int microseconds) {
+    gc.pause_budget_us = microseconds;
+}
+
+void gc_set_heap_policy(const GCHeapPolicy* policy) {
+    assert(policy->target_live_ratio > 0 && policy->target_live_ratio <= 1);
+    assert(policy->shrink_rate >= 0 && policy->shrink_rate <= 1);
+    gc.policy = *policy;
+    if (gc.policy.min_threshold < GC_NURSERY_SIZE) gc.policy.min_threshold = GC_NURSERY_SIZE;
+    if (gc.gc_threshold < gc.policy.min_threshold) gc.gc_threshold = gc.policy.min_threshold;
+    if (gc.policy.max_heap && gc.gc_threshold > gc.policy.max_heap) gc.gc_threshold = gc.policy.max_heap;
+}
+
+GCHeapPolicy gc_get_heap_policy(void) {
+    return gc.policy;
+}
+
 void gc_collect(void) {
 #ifdef GC_DEBUG
 	printf("gc_collect: disable_count=%d, bytes_allocated=%ld\n", gc.disable_count, gc.bytes_allocated);
 #endif
     if (gc.disable_count > 0) return;
+    if (gc.phase != GC_PHASE_IDLE) gc_finish_cycle();
     
+    unsigned long start = gc_now_us();
     gc.collections_count++;
+    gc.minors_since_major = 0;
+    gc_begin_record(GC_COLLECTION_MAJOR);
+#ifdef GC_DEBUG
     size_t before = gc.bytes_allocated;
+#endif
     
-    // Mark & Sweep
-    gc_mark_phase();
+    // Mark & Sweep (both generations)
+    if (gc.marks_stale) gc_clear_marks();
+    gc_mark_roots();
+    gc_drain_gray(0);
+    unsigned long marked = gc_now_us();
+    gc_clear_remembered();
     gc_sweep_phase();
+    gc_sweep_pages(false);
+    gc_sweep_young_large();
+    gc.young_bytes = 0;
     
-    // Adjust threshold based on how much we freed
-    size_t freed = before - gc.bytes_allocated;
-    if (freed < gc.gc_threshold / 4) {
-        // Didn't free much, increase threshold
-        gc.gc_threshold *= 2;
-    }
+    // Adjust threshold based on how much survived
+    gc_adjust_threshold();
+    gc.cycle.mark_us = (unsigned int)(marked - start);
+    gc.cycle.sweep_us = (unsigned int)(gc_now_us() - marked);
+    gc_end_record();
+    gc_note_pause(start);
     
 #ifdef GC_DEBUG
+    size_t freed = before - gc.bytes_allocated;
     printf("GC: freed %zu bytes, %zu bytes remaining, threshold now %zu\n", 
            freed, gc.bytes_allocated, gc.gc_threshold);
 #endif
@@ -305,31 +1293,113 @@ void gc_collect(void) {
 GCStats gc_get_stats(void) {
     GCStats stats = {
         .bytes_allocated = gc.bytes_allocated,
+        .young_bytes = gc.young_bytes,
         .gc_threshold = gc.gc_threshold,
         .collections_count = gc.collections_count,
+        .minor_collections_count = gc.minor_collections_count,
+        .emergency_collections_count = gc.emergency_collections_count,
+        .page_count = gc.page_count,
+        .free_page_count = gc.free_page_count,
         .root_count = gc.root_set.count,
-        .is_enabled = (gc.disable_count == 0)
+        .root_range_count = gc.root_ranges.count,
+        .pause_budget_us = gc.pause_budget_us,
+        .max_pause_us = gc.max_pause_us,
+        .incremental_steps_count = gc.incremental_steps_count,
+        .is_enabled = (gc.disable_count == 0),
+        .is_collecting = (gc.phase != GC_PHASE_IDLE)
     };
     return stats;
 }
 
+int gc_get_collection_history(GCCollectionRecord* out, int max) {
+    int n = gc.history_count < GC_HISTORY_SIZE ? gc.history_count : GC_HISTORY_SIZE;
+    if (n > max) n = max;
+    for (int i = 0; i < n; i++) {
+        out[i] = gc.history[(gc.history_count - 1 - i) % GC_HISTORY_SIZE];
+    }
+    return n;
+}
+
+void gc_get_pause_histogram(int counts[GC_PAUSE_BUCKETS]) {
+    for (int i = 0; i < GC_PAUSE_BUCKETS; i++) counts[i] = 0;
+    int n = gc.pause_count < GC_PAUSE_HISTORY ? gc.pause_count : GC_PAUSE_HISTORY;
+    for (int i = 0; i < n; i++) {
+        unsigned int pause = gc.pauses[i];
+        int bucket = 0;
+        while (pause > 0 && bucket < GC_PAUSE_BUCKETS - 1) {
+            pause >>= 1;
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+}
+
 // Accessor functions for debug output (used by gc_debug_output.c)
-// These allow traversing internal GC structures without exposing implementation details
+// These allow traversing internal GC structures without exposing implementation details.
+// Objects are visited in this order: old large objects, page cells (by size
+// class, page by page), young large objects.
+static inline void* gc_large_header(GCLargeObject* obj) {
+    return obj ? &obj->header : NULL;
+}
+
+static void* gc_first_cell_from(int size_class, GCPage* page) {
+    for (; size_class < GC_SIZE_CLASS_COUNT; size_class++) {
+        if (!page) page = gc.classes[size_class].pages;
+        for (; page; page = page->next) {
+            for (char* p = GC_PAGE_FIRST_CELL(page); p < page->top; p += page->cell_size) {
+                if (!(((GCObject*)p)->flags & GC_FLAG_FREE)) return p;
+            }
+        }
+    }
+    return gc_large_header(gc.young_large);
+}
+
 void* gc_get_all_objects(void) {
-    return gc.all_objects;
+    if (gc.all_objects) return &gc.all_objects->header;
+    return gc_first_cell_from(0, NULL);
 }
 
 void* gc_get_next_object(void* obj) {
     if (!obj) return NULL;
-    return ((GCObject*)obj)->next;
+    GCObject* o = (GCObject*)obj;
+    if (o->flags & GC_FLAG_LARGE) {
+        GCLargeObject* next = GC_LARGE_OF(o)->next;
+        if (next || !(o->flags & GC_FLAG_OLD)) return gc_large_header(next);
+        return gc_first_cell_from(0, NULL);
+    }
+    GCPage* page = GC_PAGE_OF(o);
+    for (char* p = (char*)o + page->cell_size; p < page->top; p += page->cell_size) {
+        if (!(((GCObject*)p)->flags & GC_FLAG_FREE)) return p;
+    }
+    if (page->next) return gc_first_cell_from(page->size_class, page->next);
+    return gc_first_cell_from(page->size_class + 1, NULL);
 }
 
 size_t gc_get_object_size(void* obj) {
     if (!obj) return 0;
-    return ((GCObject*)obj)->size;
+    GCObject* o = (GCObject*)obj;
+    if (o->flags & GC_FLAG_LARGE) return GC_LARGE_OF(o)->size;
+    return GC_PAGE_OF(o)->cell_size;
+}
+
+GCObjectType gc_get_object_type(void* obj) {
+    if (!obj) return GC_TYPE_OTHER;
+    return (GCObjectType)((GCObject*)obj)->type;
+}
+
+void gc_get_type_stats(GCTypeStats out[GC_TYPE_COUNT]) {
+    for (int i = 0; i < GC_TYPE_COUNT; i++) {
+        out[i].count = 0;
+        out[i].bytes = 0;
+    }
+    for (void* obj = gc_get_all_objects(); obj; obj = gc_get_next_object(obj)) {
+        GCObjectType type = gc_get_object_type(obj);
+        out[type].count++;
+        out[type].bytes += gc_get_object_size(obj);
+    }
 }
 
 bool gc_is_object_marked(void* obj) {
     if (!obj) return false;
-    return ((GCObject*)obj)->marked;
+    return gc_is_marked((GCObject*)obj);
 }
@@ -23,18 +23,84 @@ extern "C" {
 void gc_init(void);
 void gc_shutdown(void);
 
-// Memory allocation (returns GC-managed memory)
-void* gc_allocate(size_t size);
+// Memory allocation (returns GC-managed memory).  The type is recorded in
+// the object header, for heap statistics (see gc_get_type_stats); when an
+// object of type GC_TYPE_INTERNED_STRING is freed, it is uninterned.
+// Anything allocated before gc_init (e.g. by static initializers) is
+// permanent, as if allocated by gc_allocate_immortal.
+void* gc_allocate(size_t size, GCObjectType type);
+
+// Allocate memory that is never collected, but which the GC can still
+// recognize if it finds a reference to it (e.g. interned strings)
+void* gc_allocate_immortal(size_t size);
+
+// True if the object (as returned by gc_allocate) is garbage that just
+// hasn't been swept yet, as can happen while an incremental collection is
+// sweeping.  A weak reference to such an object (such as the intern table's)
+// must treat it as already gone.
+bool gc_is_dying(void* ptr);
+
+// Write barrier: call after storing a Value into an existing list or map
+// (passing the container).  New objects are allocated in a nursery that a
+// minor collection scans without looking at the old space, so any old
+// container that may now point to a young object must be remembered.
+void gc_write_barrier(Value container);
 
 // Manual garbage collection control
 void gc_collect(void);
 void gc_disable(void);
 void gc_enable(void);
 
+// Incremental mode: if the budget is nonzero, major collections are done in
+// steps (interleaved with allocation) of roughly this many microseconds each,
+// rather than all at once.  0 (the default) means stop-the-world collection.
+// Minor collections are always done all at once.
+void gc_set_pause_budget(unsigned int microseconds);
+
+// Heap sizing policy.  After each major collection, the threshold for the
+// next one is set so that the surviving data is target_live_ratio of it
+// (0.5 means "collect again once the heap has doubled").  If that's lower
+// than the current threshold, we move only shrink_rate of the way down
+// each time.  The threshold never goes below min_threshold.  If max_heap
+// is nonzero, allocating past it forces an immediate full collection, and
+// if that doesn't make room, we report out of memory and exit.  With
+// release_pages, the memory of empty pages is handed back to the OS.
+typedef struct {
+    double target_live_ratio;   // live bytes / threshold (0 to 1; default 0.5)
+    double shrink_rate;         // 0 to 1 (default 0.5)
+    size_t min_threshold;       // bytes (default 1MB)
+    size_t max_heap;            // bytes, or 0 for no limit (the default)
+    bool release_pages;         // default true
+} GCHeapPolicy;
+
+void gc_set_heap_policy(const GCHeapPolicy* policy);
+GCHeapPolicy gc_get_heap_policy(void);
+
 // Root set management for local variables
 void gc_protect_value(Value* val_ptr);
 void gc_unprotect_value(void);
 
+// Root ranges: arrays of Values living outside the shadow stack (such as the
+// VM's register stack), which every collection scans in full.  Items are
+// `stride` bytes apart (just sizeof(Value) for a plain Value array).  If
+// live_count is not NULL, it's called with `context` at collection time to
+// get the number of items currently in use; otherwise all `count` are used.
+// live_count should only report the count (it may be called more than once
+// per collection); tidying up before the scan is what scan hooks are for.
+// The base pointer must stay valid until the range is removed.
+typedef int (*GCLiveCountFunc)(void* context);
+int gc_add_root_range(Value* base, int count, size_t stride,
+                      GCLiveCountFunc live_count, void* context);
+void gc_remove_root_range(int handle);
+
+// Root scan hooks: called with `context` at the start of every root scan
+// (before any live_count), so the owner of some roots can put them in order
+// first -- e.g. the VM nulls registers above its stack top, which the scan
+// will skip.  Returns a handle for gc_remove_root_scan_hook.
+typedef void (*GCRootScanHook)(void* context);
+int gc_add_root_scan_hook(GCRootScanHook hook, void* context);
+void gc_remove_root_scan_hook(int handle);
+
 // Scope management macros for automatic root tracking
 #define GC_PUSH_SCOPE() gc_push_scope()
 #define GC_POP_SCOPE() gc_pop_scope()
@@ -43,7 +109,7 @@ void gc_unprotect_value(void);
 #define GC_LOCALS(...) \
     do { \
         Value* _locals[] = {__VA_ARGS__}; \
-        for (int _i = 0; _i < sizeof(_locals)/sizeof(_locals[0]); _i++) { \
+        for (size_t _i = 0; _i < sizeof(_locals)/sizeof(_locals[0]); _i++) { \
             gc_protect_value(_locals[_i]); \
         } \
     } while(0)
@@ -58,19 +124,71 @@ void gc_pop_scope(void);
 // GC statistics and debugging
 typedef struct {
     size_t bytes_allocated;
+    size_t young_bytes;          // allocated since the last collection
     size_t gc_threshold;
     int collections_count;
+    int minor_collections_count;
+    int emergency_collections_count; // forced by GCHeapPolicy.max_heap
+    int page_count;                  // size-class pages in use
+    int free_page_count;             // empty pages kept for reuse
     int root_count;
+    int root_range_count;
+    unsigned int pause_budget_us;    // see gc_set_pause_budget
+    unsigned int max_pause_us;       // longest single collection pause so far
+    int incremental_steps_count;
     bool is_enabled;
+    bool is_collecting;              // incremental collection in progress
 } GCStats;
 
 GCStats gc_get_stats(void);
 
+// Telemetry.  A record is kept for each of the most recent collections
+// (minor, stop-the-world major, or incremental major; for the latter, the
+// times are totals over all its steps).
+typedef enum {
+    GC_COLLECTION_MINOR,
+    GC_COLLECTION_MAJOR,
+    GC_COLLECTION_INCREMENTAL
+} GCCollectionKind;
+
+typedef struct {
+    GCCollectionKind kind;
+    unsigned int mark_us;        // time spent marking
+    unsigned int sweep_us;       // time spent sweeping
+    size_t bytes_freed;
+    size_t bytes_after;          // bytes_allocated when the collection ended
+    size_t objects_marked;
+} GCCollectionRecord;
+
+#define GC_HISTORY_SIZE 32
+
+// Copy up to max of the most recent collection records (most recent first)
+// into out; returns how many were copied.
+int gc_get_collection_history(GCCollectionRecord* out, int max);
+
+// Histogram of the most recent (up to 256) pauses: a minor collection, a
+// full collection, or one incremental step.  Bucket 0 counts pauses under
+// 1 us; bucket i counts pauses of at least 2^(i-1) but under 2^i us; the
+// last bucket also counts everything longer.
+#define GC_PAUSE_BUCKETS 16
+void gc_get_pause_histogram(int counts[GC_PAUSE_BUCKETS]);
+
+// Live objects and bytes by type (walks the whole heap, so it's slow).
+// Objects that are garbage but not yet swept are included, so this is only
+// exact right after gc_collect().  Immortal objects are not included.
+typedef struct {
+    int count;
+    size_t bytes;
+} GCTypeStats;
+
+void gc_get_type_stats(GCTypeStats out[GC_TYPE_COUNT]);
+
 // Accessor functions for debug output (used by gc_debug_output.c)
 // These allow traversing internal GC structures without exposing implementation details
 void* gc_get_all_objects(void);
 void* gc_get_next_object(void* obj);
 size_t gc_get_object_size(void* obj);
+GCObjectType gc_get_object_type(void* obj);
 bool gc_is_object_marked(void* obj);
 void gc_mark_phase(void);  // Exposed for gc_mark_and_report
 
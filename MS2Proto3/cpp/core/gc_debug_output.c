@@ -48,6 +48,9 @@ void debug_print_value(Value v) {
     } else if (is_map(v)) {
         uintptr_t ptr = (uintptr_t)(v & 0xFFFFFFFFFFFFULL);
         printf("map(ptr=0x%llx)", (unsigned long long)ptr);
+    } else if (is_range(v)) {
+        uintptr_t ptr = (uintptr_t)(v & 0xFFFFFFFFFFFFULL);
+        printf("range(ptr=0x%llx)", (unsigned long long)ptr);
     } else {
         printf("unknown(0x%016llx)", v);
     }
@@ -61,6 +64,7 @@ const char* value_type_name(Value v) {
     if (is_heap_string(v)) return "heap_string";
     if (is_list(v)) return "list";
     if (is_map(v)) return "map";
+    if (is_range(v)) return "range";
     return "unknown";
 }
 
@@ -92,12 +96,10 @@ void print_string_escaped(const char* str, int len, int max_len) {
     }
 }
 
-// Access to intern table internals (declared in value_string.c)
-extern void* value_string_get_intern_table(void);
-extern void* value_string_get_intern_entry_at(int bucket);
-extern void* value_string_get_next_intern_entry(void* entry);
-extern Value value_string_get_entry_value(void* entry);
+// Access to intern table internals (declared in value_string.h)
+extern StringStorage* value_string_get_intern_entry_at(int slot);
 extern int value_string_get_intern_table_size(void);
+extern int value_string_get_intern_count(void);
 extern bool value_string_is_intern_table_initialized(void);
 
 void dump_intern_table(void) {
@@ -108,59 +110,37 @@ void dump_intern_table(void) {
     }
 
     int table_size = value_string_get_intern_table_size();
+    int total_entries = value_string_get_intern_count();
     printf("\n=== Intern Table ===\n");
-    printf("Table size: %d buckets\n", table_size);
-
-    int total_entries = 0;
-    int used_buckets = 0;
-    int max_chain_length = 0;
+    printf("Table size: %d slots\n", table_size);
+    printf("Total interned strings: %d\n", total_entries);
+    printf("Load factor: %.2f\n", (float)total_entries / table_size);
 
-    // Count entries and analyze distribution
+    // Find how far entries are from their home slots
+    int max_probe_length = 0;
+    long total_probe_length = 0;
     for (int i = 0; i < table_size; i++) {
-        void* entry = value_string_get_intern_entry_at(i);
-        if (entry != NULL) {
-            used_buckets++;
-            int chain_length = 0;
-            while (entry != NULL) {
-                chain_length++;
-                total_entries++;
-                entry = value_string_get_next_intern_entry(entry);
-            }
-            if (chain_length > max_chain_length) {
-                max_chain_length = chain_length;
-            }
-        }
+        StringStorage* str = value_string_get_intern_entry_at(i);
+        if (!str) continue;
+        int probe_length = (i - (int)(str->hash & (table_size - 1))) & (table_size - 1);
+        total_probe_length += probe_length;
+        if (probe_length > max_probe_length) max_probe_length = probe_length;
     }
-
-    printf("Total interned strings: %d\n", total_entries);
-    printf("Used buckets: %d / %d\n", used_buckets, table_size);
-    printf("Max chain length: %d\n", max_chain_length);
-    printf("Avg chain length: %.2f\n",
-           used_buckets > 0 ? (float)total_entries / used_buckets : 0.0f);
+    printf("Max probe length: %d\n", max_probe_length);
+    printf("Avg probe length: %.2f\n",
+           total_entries > 0 ? (float)total_probe_length / total_entries : 0.0f);
     printf("\nInterned strings:\n");
 
     // Dump all interned strings
     int string_num = 0;
-    for (int bucket = 0; bucket < table_size; bucket++) {
-        void* entry = value_string_get_intern_entry_at(bucket);
-        while (entry != NULL) {
-            string_num++;
-
-            Value str_val = value_string_get_entry_value(entry);
-            if (is_heap_string(str_val)) {
-                StringStorage* str = as_string(str_val);
-                if (str) {
-                    printf("  [%d] bucket=%d hash=0x%08x len=%d \"",
-                           string_num, bucket, str->hash, str->lenB);
-                    print_string_escaped(str->data, str->lenB, 60);
-                    printf("\"\n");
-                }
-            } else {
-                printf("  [%d] bucket=%d (not a heap string?)\n", string_num, bucket);
-            }
-
-            entry = value_string_get_next_intern_entry(entry);
-        }
+    for (int slot = 0; slot < table_size; slot++) {
+        StringStorage* str = value_string_get_intern_entry_at(slot);
+        if (!str) continue;
+        string_num++;
+        printf("  [%d] slot=%d hash=0x%08x len=%d \"",
+               string_num, slot, str->hash, str->lenB);
+        print_string_escaped(str->data, str->lenB, 60);
+        printf("\"\n");
     }
 
     if (total_entries == 0) {
@@ -179,9 +159,18 @@ void dump_intern_table(void) {
 extern void* gc_get_all_objects(void);
 extern void* gc_get_next_object(void* obj);
 extern size_t gc_get_object_size(void* obj);
+extern GCObjectType gc_get_object_type(void* obj);
 extern bool gc_is_object_marked(void* obj);
 extern void gc_mark_phase(void);
 
+static const char* gc_type_names[GC_TYPE_COUNT] = {
+    "other", "string", "interned_string", "list", "map", "map_entries", "funcref", "varmap_data", "range"
+};
+
+static const char* gc_collection_kind_names[] = {
+    "minor", "major", "incremental"
+};
+
 static void print_hex_ascii_line(const unsigned char* data, size_t offset, size_t data_size) {
     // Print offset
     printf("  %04zx: ", offset);
@@ -215,9 +204,9 @@ void gc_dump_objects(void) {
     GCStats stats = gc_get_stats();
 
     printf("\n=== GC Objects Dump ===\n");
-    printf("Total allocated: %zu bytes\n", stats.bytes_allocated);
+    printf("Total allocated: %zu bytes (%zu young)\n", stats.bytes_allocated, stats.young_bytes);
     printf("GC threshold: %zu bytes\n", stats.gc_threshold);
-    printf("Collections: %d\n\n", stats.collections_count);
+    printf("Collections: %d (plus %d minor)\n\n", stats.collections_count, stats.minor_collections_count);
 
     int object_count = 0;
     void* obj = gc_get_all_objects();
@@ -227,7 +216,7 @@ void gc_dump_objects(void) {
 
         // Get pointer to actual data (after GCObject header)
         size_t obj_size = gc_get_object_size(obj);
-        size_t header_size = 16;  // sizeof(GCObject) - hardcoded to avoid exposing struct
+        size_t header_size = 8;  // sizeof(GCObject) - hardcoded to avoid exposing struct
         unsigned char* data = (unsigned char*)obj + header_size;
         size_t data_size = obj_size - header_size;
 
@@ -235,20 +224,15 @@ void gc_dump_objects(void) {
         printf("  Size: %zu bytes (+ %zu header = %zu total)\n",
                data_size, header_size, obj_size);
         printf("  Marked: %s\n", gc_is_object_marked(obj) ? "YES" : "no");
-
-        // Try to heuristically identify if this looks like a StringStorage
-        if (data_size >= sizeof(StringStorage)) {
-            StringStorage* maybe_str = (StringStorage*)data;
-            // Check if lengths are reasonable and hash is non-zero
-            if (maybe_str->lenB >= 0 && maybe_str->lenB < 10000 &&
-                maybe_str->lenC >= -1 && maybe_str->lenC <= maybe_str->lenB &&
-                maybe_str->hash != 0) {
-                printf("  Type hint: Possibly StringStorage (lenB=%d, lenC=%d, hash=0x%08x)\n",
-                       maybe_str->lenB, maybe_str->lenC, maybe_str->hash);
-                printf("  String data: \"");
-                print_string_escaped(maybe_str->data, maybe_str->lenB, 60);
-                printf("\"\n");
-            }
+        printf("  Type: %s\n", gc_type_names[gc_get_object_type(obj)]);
+
+        if (gc_get_object_type(obj) == GC_TYPE_STRING || gc_get_object_type(obj) == GC_TYPE_INTERNED_STRING) {
+            StringStorage* str = (StringStorage*)data;
+            printf("  StringStorage: lenB=%d, lenC=%d, hash=0x%08x\n",
+                   str->lenB, str->lenC, str->hash);
+            printf("  String data: \"");
+            print_string_escaped(str->data, str->lenB, 60);
+            printf("\"\n");
         }
 
         // Hex/ASCII dump (first 64 bytes or less)
@@ -313,23 +297,21 @@ void gc_mark_and_report(void) {
     while (obj) {
         if (gc_is_object_marked(obj)) {
             obj_num++;
-            size_t header_size = 16;  // sizeof(GCObject)
+            size_t header_size = 8;  // sizeof(GCObject)
             unsigned char* data = (unsigned char*)obj + header_size;
             size_t obj_size = gc_get_object_size(obj);
             size_t data_size = obj_size - header_size;
+            GCObjectType type = gc_get_object_type(obj);
+
+            printf("\n#%d @ %p: %s, %zu bytes\n", obj_num, (void*)obj,
+                   gc_type_names[type], data_size);
 
-            printf("\n#%d @ %p: %zu bytes\n", obj_num, (void*)obj, data_size);
-
-            // Try to identify type
-            if (data_size >= sizeof(StringStorage)) {
-                StringStorage* maybe_str = (StringStorage*)data;
-                if (maybe_str->lenB >= 0 && maybe_str->lenB < 10000 &&
-                    maybe_str->lenC >= -1 && maybe_str->lenC <= maybe_str->lenB) {
-                    printf("  [StringStorage: lenB=%d, hash=0x%08x] \"",
-                           maybe_str->lenB, maybe_str->hash);
-                    print_string_escaped(maybe_str->data, maybe_str->lenB, 60);
-                    printf("\"\n");
-                }
+            if (type == GC_TYPE_STRING || type == GC_TYPE_INTERNED_STRING) {
+                StringStorage* str = (StringStorage*)data;
+                printf("  [StringStorage: lenB=%d, hash=0x%08x] \"",
+                       str->lenB, str->hash);
+                print_string_escaped(str->data, str->lenB, 60);
+                printf("\"\n");
             }
         }
         obj = gc_get_next_object(obj);
@@ -338,3 +320,42 @@ void gc_mark_and_report(void) {
     printf("\n=== End Report ===\n");
     printf("Note: Marks remain set. Run gc_collect() to sweep and clear marks.\n");
 }
+
+void gc_dump_telemetry(void) {
+    GCStats stats = gc_get_stats();
+    printf("{\n  \"stats\": {\"bytes_allocated\": %zu, \"young_bytes\": %zu, "
+           "\"gc_threshold\": %zu, \"collections\": %d, \"minor_collections\": %d, "
+           "\"emergency_collections\": %d, \"incremental_steps\": %d, "
+           "\"pages\": %d, \"free_pages\": %d, \"max_pause_us\": %u},\n",
+           stats.bytes_allocated, stats.young_bytes, stats.gc_threshold,
+           stats.collections_count, stats.minor_collections_count,
+           stats.emergency_collections_count, stats.incremental_steps_count,
+           stats.page_count, stats.free_page_count, stats.max_pause_us);
+
+    GCCollectionRecord history[GC_HISTORY_SIZE];
+    int count = gc_get_collection_history(history, GC_HISTORY_SIZE);
+    printf("  \"history\": [");
+    for (int i = 0; i < count; i++) {
+        GCCollectionRecord* rec = &history[i];
+        printf("%s\n    {\"kind\": \"%s\", \"mark_us\": %u, \"sweep_us\": %u, "
+               "\"bytes_freed\": %zu, \"bytes_after\": %zu, \"objects_marked\": %zu}",
+               i ? "," : "", gc_collection_kind_names[rec->kind], rec->mark_us, rec->sweep_us,
+               rec->bytes_freed, rec->bytes_after, rec->objects_marked);
+    }
+    printf("%s],\n", count ? "\n  " : "");
+
+    int pauses[GC_PAUSE_BUCKETS];
+    gc_get_pause_histogram(pauses);
+    printf("  \"pause_histogram\": [");
+    for (int i = 0; i < GC_PAUSE_BUCKETS; i++) printf("%s%d", i ? ", " : "", pauses[i]);
+    printf("],\n");
+
+    GCTypeStats types[GC_TYPE_COUNT];
+    gc_get_type_stats(types);
+    printf("  \"types\": {");
+    for (int i = 0; i < GC_TYPE_COUNT; i++) {
+        printf("%s\n    \"%s\": {\"count\": %d, \"bytes\": %zu}",
+               i ? "," : "", gc_type_names[i], types[i].count, types[i].bytes);
+    }
+    printf("\n  }\n}\n");
+}
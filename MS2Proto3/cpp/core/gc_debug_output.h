@@ -25,6 +25,7 @@ void dump_intern_table(void);
 // GC debugging
 void gc_dump_objects(void);
 void gc_mark_and_report(void);
+void gc_dump_telemetry(void);  // stats, recent collections, pauses, and heap by type, as JSON
 
 #ifdef __cplusplus
 }
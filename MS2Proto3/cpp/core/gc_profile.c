@@ -0,0 +1,313 @@
+// gc_profile.c - Sampling allocation-site heap profiler (see gc_profile.h)
+
+#include "gc_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+
+#include "layer_defs.h"
+#if LAYER_2A_HIGHER
+#error "gc_profile.c (Layer 2A) cannot depend on higher layers (3A, 4)"
+#endif
+#if LAYER_2A_BSIDE
+#error "gc_profile.c (Layer 2A - runtime) cannot depend on B-side layers (2B, 3B)"
+#endif
+
+#define GC_PROFILE_MAX_DEPTH 64     // Deepest call stack recorded per sample
+
+// A distinct allocation call stack, and what has been allocated there
+typedef struct {
+    int depth;
+    GCAllocSite* frames;        // innermost (the allocation site itself) first
+    unsigned int hash;
+    double alloc_bytes;         // estimated bytes allocated here
+} GCProfileStack;
+
+// A sampled object that has not been freed yet
+typedef struct {
+    void* obj;                  // NULL if this slot is empty
+    int stack;                  // index into profile.stacks
+    int age;                    // collections survived
+    double weight;              // estimated bytes this sample stands for
+} GCProfileSample;
+
+typedef struct {
+    bool active;
+    double mean_interval;       // sample_bytes
+    uint64_t rng;
+    GCProfileStack* stacks;
+    int stack_count;
+    int stack_capacity;
+    int* stack_index;           // hash table of stack indexes (-1 if empty)
+    int stack_index_capacity;   // (a power of 2)
+    GCProfileSample* samples;   // hash table by object address
+    int sample_count;
+    int sample_capacity;        // (a power of 2)
+    char** names;               // function names, by function index
+    int name_count;
+    GCProfileStackFunc stack_func;
+    GCProfileNameFunc name_func;
+    void* hook_context;
+} GCProfile;
+
+static GCProfile profile = {0};
+
+GCAllocSite gc_alloc_site = {-1, 0};
+long gc_profile_bytes_left = LONG_MAX;
+
+void gc_profile_set_hooks(GCProfileStackFunc stack, GCProfileNameFunc name, void* context) {
+    profile.stack_func = stack;
+    profile.name_func = name;
+    profile.hook_context = context;
+}
+
+//--------------------------------------------------------------------------
+// Sampling intervals are drawn from an exponential distribution (so the
+// sample points form a Poisson process over the allocated bytes), and each
+// sample is weighted by the inverse of its probability of being sampled.
+
+static double gc_profile_random(void) {
+    // xorshift64*, giving a double in (0, 1]
+    profile.rng ^= profile.rng >> 12;
+    profile.rng ^= profile.rng << 25;
+    profile.rng ^= profile.rng >> 27;
+    uint64_t r = profile.rng * 0x2545F4914F6CDD1DULL;
+    return ((r >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static void gc_profile_next_interval(void) {
+    double interval = -log(gc_profile_random()) * profile.mean_interval;
+    gc_profile_bytes_left = interval < 1 ? 1 : (long)interval;
+}
+
+static double gc_profile_weight(size_t size) {
+    double ratio = (double)size / profile.mean_interval;
+    return (double)size / (1.0 - exp(-ratio));
+}
+
+//--------------------------------------------------------------------------
+// Stacks
+
+static unsigned int gc_profile_hash_frames(const GCAllocSite* frames, int depth) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < depth; i++) {
+        hash = (hash ^ (unsigned int)frames[i].function) * 16777619u;
+        hash = (hash ^ (unsigned int)frames[i].pc) * 16777619u;
+    }
+    return hash;
+}
+
+static void gc_profile_grow_stack_index(void) {
+    int capacity = profile.stack_index_capacity ? profile.stack_index_capacity * 2 : 256;
+    int* index = malloc(sizeof(int) * capacity);
+    for (int i = 0; i < capacity; i++) index[i] = -1;
+    for (int s = 0; s < profile.stack_count; s++) {
+        int i = profile.stacks[s].hash & (capacity - 1);
+        while (index[i] >= 0) i = (i + 1) & (capacity - 1);
+        index[i] = s;
+    }
+    free(profile.stack_index);
+    profile.stack_index = index;
+    profile.stack_index_capacity = capacity;
+}
+
+// Find the given stack, adding it if it's new; returns its index.
+static int gc_profile_find_stack(const GCAllocSite* frames, int depth) {
+    unsigned int hash = gc_profile_hash_frames(frames, depth);
+    int mask = profile.stack_index_capacity - 1;
+    int i = hash & mask;
+    for (; profile.stack_index[i] >= 0; i = (i + 1) & mask) {
+        GCProfileStack* stack = &profile.stacks[profile.stack_index[i]];
+        if (stack->hash == hash && stack->depth == depth
+            && memcmp(stack->frames, frames, sizeof(GCAllocSite) * depth) == 0) {
+            return profile.stack_index[i];
+        }
+    }
+
+    if (profile.stack_count >= profile.stack_capacity) {
+        profile.stack_capacity = profile.stack_capacity ? profile.stack_capacity * 2 : 64;
+        profile.stacks = realloc(profile.stacks, sizeof(GCProfileStack) * profile.stack_capacity);
+    }
+    int s = profile.stack_count++;
+    GCProfileStack* stack = &profile.stacks[s];
+    stack->depth = depth;
+    stack->frames = malloc(sizeof(GCAllocSite) * depth);
+    memcpy(stack->frames, frames, sizeof(GCAllocSite) * depth);
+    stack->hash = hash;
+    stack->alloc_bytes = 0;
+    profile.stack_index[i] = s;
+    if (profile.stack_count * 2 > profile.stack_index_capacity) gc_profile_grow_stack_index();
+    return s;
+}
+
+// Get the name of the given function, looking it up (and keeping a copy)
+// the first time it's needed, while the interpreter still has it.
+static const char* gc_profile_function_name(int function) {
+    if (function < 0) return "(host)";
+    if (function >= profile.name_count) {
+        int count = function + 1;
+        profile.names = realloc(profile.names, sizeof(char*) * count);
+        for (int i = profile.name_count; i < count; i++) profile.names[i] = NULL;
+        profile.name_count = count;
+    }
+    if (!profile.names[function]) {
+        const char* name = profile.name_func ? profile.name_func(profile.hook_context, function) : NULL;
+        char buf[16];
+        if (!name) {
+            snprintf(buf, sizeof(buf), "func%d", function);
+            name = buf;
+        }
+        size_t len = strlen(name) + 1;
+        profile.names[function] = memcpy(malloc(len), name, len);
+    }
+    return profile.names[function];
+}
+
+//--------------------------------------------------------------------------
+// Samples (a hash table of live sampled objects, with linear probing)
+
+static inline int gc_profile_slot(void* obj, int capacity) {
+    uint64_t h = ((uint64_t)(uintptr_t)obj >> 3) * 0x9E3779B97F4A7C15ULL;
+    return (int)(h >> 32) & (capacity - 1);
+}
+
+static void gc_profile_insert_sample(GCProfileSample sample) {
+    int mask = profile.sample_capacity - 1;
+    int i = gc_profile_slot(sample.obj, profile.sample_capacity);
+    while (profile.samples[i].obj) i = (i + 1) & mask;
+    profile.samples[i] = sample;
+    profile.sample_count++;
+}
+
+static void gc_profile_grow_samples(void) {
+    GCProfileSample* old = profile.samples;
+    int old_capacity = profile.sample_capacity;
+    profile.sample_capacity = old_capacity ? old_capacity * 2 : 256;
+    profile.samples = calloc(profile.sample_capacity, sizeof(GCProfileSample));
+    profile.sample_count = 0;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].obj) gc_profile_insert_sample(old[i]);
+    }
+    free(old);
+}
+
+bool gc_profile_sample(void* obj, size_t size) {
+    if (!profile.active) {
+        gc_profile_bytes_left = LONG_MAX;
+        return false;
+    }
+    gc_profile_next_interval();
+
+    GCAllocSite frames[GC_PROFILE_MAX_DEPTH];
+    frames[0] = gc_alloc_site;
+    if (frames[0].function < 0) frames[0].pc = 0;
+    int depth = 1;
+    if (profile.stack_func && gc_alloc_site.function >= 0) {
+        depth += profile.stack_func(profile.hook_context, frames + 1, GC_PROFILE_MAX_DEPTH - 1);
+    }
+    for (int i = 0; i < depth; i++) gc_profile_function_name(frames[i].function);
+    int s = gc_profile_find_stack(frames, depth);
+
+    GCProfileSample sample = {obj, s, 0, gc_profile_weight(size)};
+    profile.stacks[s].alloc_bytes += sample.weight;
+    if ((profile.sample_count + 1) * 2 > profile.sample_capacity) gc_profile_grow_samples();
+    gc_profile_insert_sample(sample);
+    return true;
+}
+
+void gc_profile_freed(void* obj) {
+    if (!profile.sample_capacity) return;
+    int mask = profile.sample_capacity - 1;
+    int i = gc_profile_slot(obj, profile.sample_capacity);
+    while (profile.samples[i].obj != obj) {
+        if (!profile.samples[i].obj) return;  // (sampled before the profile was restarted)
+        i = (i + 1) & mask;
+    }
+
+    // Remove it, and move up any later entries that could no longer be
+    // found past the gap
+    profile.sample_count--;
+    for (int j = (i + 1) & mask; profile.samples[j].obj; j = (j + 1) & mask) {
+        int home = gc_profile_slot(profile.samples[j].obj, profile.sample_capacity);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            profile.samples[i] = profile.samples[j];
+            i = j;
+        }
+    }
+    profile.samples[i].obj = NULL;
+}
+
+void gc_profile_collection_done(void) {
+    if (!profile.sample_count) return;
+    for (int i = 0; i < profile.sample_capacity; i++) {
+        if (profile.samples[i].obj && profile.samples[i].age < INT_MAX) profile.samples[i].age++;
+    }
+}
+
+//--------------------------------------------------------------------------
+// Control and reports
+
+void gc_profile_stop(void) {
+    for (int s = 0; s < profile.stack_count; s++) free(profile.stacks[s].frames);
+    free(profile.stacks);
+    free(profile.stack_index);
+    free(profile.samples);
+    for (int i = 0; i < profile.name_count; i++) free(profile.names[i]);
+    free(profile.names);
+
+    GCProfileStackFunc stack_func = profile.stack_func;
+    GCProfileNameFunc name_func = profile.name_func;
+    void* hook_context = profile.hook_context;
+    memset(&profile, 0, sizeof(profile));
+    gc_profile_set_hooks(stack_func, name_func, hook_context);
+    gc_profile_bytes_left = LONG_MAX;
+}
+
+void gc_profile_start(size_t sample_bytes) {
+    gc_profile_stop();
+    profile.active = true;
+    profile.mean_interval = (double)(sample_bytes ? sample_bytes : GC_PROFILE_DEFAULT_SAMPLE_BYTES);
+    profile.rng = 0x853C49E6748FEA9BULL;
+    gc_profile_grow_stack_index();
+    gc_profile_grow_samples();
+    gc_profile_next_interval();
+}
+
+bool gc_profile_is_active(void) {
+    return profile.active;
+}
+
+int gc_profile_write(const char* path, GCProfileReport report) {
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    double* bytes = calloc(profile.stack_count ? profile.stack_count : 1, sizeof(double));
+    if (report == GC_PROFILE_ALLOCATED) {
+        for (int s = 0; s < profile.stack_count; s++) bytes[s] = profile.stacks[s].alloc_bytes;
+    } else {
+        int min_age = (report == GC_PROFILE_SURVIVORS) ? 1 : 0;
+        for (int i = 0; i < profile.sample_capacity; i++) {
+            GCProfileSample* sample = &profile.samples[i];
+            if (sample->obj && sample->age >= min_age) bytes[sample->stack] += sample->weight;
+        }
+    }
+
+    int lines = 0;
+    for (int s = 0; s < profile.stack_count; s++) {
+        size_t total = (size_t)(bytes[s] + 0.5);
+        if (!total) continue;
+        GCProfileStack* stack = &profile.stacks[s];
+        for (int i = stack->depth - 1; i >= 0; i--) {
+            fprintf(out, "%s:%04d%s", gc_profile_function_name(stack->frames[i].function),
+                    stack->frames[i].pc, i ? ";" : " ");
+        }
+        fprintf(out, "%zu\n", total);
+        lines++;
+    }
+    free(bytes);
+    fclose(out);
+    return lines;
+}
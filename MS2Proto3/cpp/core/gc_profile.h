@@ -0,0 +1,79 @@
+// gc_profile.h - Sampling allocation-site heap profiler
+//
+// Roughly every sample_bytes bytes allocated through gc_allocate, the object
+// being allocated is sampled: we note where it was allocated (the current
+// allocation site, plus its callers), and follow it until it is freed.  The
+// results can be written as "folded stacks" (one line per call stack, then
+// a byte count), the input format of flamegraph.pl and speedscope.
+//
+// Each sample stands for about sample_bytes of allocation (the sampling is
+// randomized, and the counts scaled, so that the totals are unbiased), so
+// the reported bytes are estimates; the more samples, the better.
+
+#ifndef GC_PROFILE_H
+#define GC_PROFILE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// This module is part of Layer 2A (Runtime Value System + GC)
+#define CORE_LAYER_2A
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GC_PROFILE_DEFAULT_SAMPLE_BYTES (128 * 1024)
+
+// The current allocation site.  The interpreter keeps this up to date (the
+// function on every call and return, and the PC on every instruction),
+// so that it costs next to nothing when we're not sampling.  A function of
+// -1 means host code, not the interpreter.
+typedef struct {
+    int function;   // function index (see GCProfileNameFunc)
+    int pc;         // instruction index within that function
+} GCAllocSite;
+
+extern GCAllocSite gc_alloc_site;
+
+// Hooks the interpreter provides, called only when an allocation is
+// sampled: one to get the sites of the calls leading to the current
+// function (innermost first; returns how many it stored, up to max), and
+// one to get the name of a function.
+typedef int (*GCProfileStackFunc)(void* context, GCAllocSite* callers, int max);
+typedef const char* (*GCProfileNameFunc)(void* context, int function);
+void gc_profile_set_hooks(GCProfileStackFunc stack, GCProfileNameFunc name, void* context);
+
+// Start sampling (discarding any previous profile), or stop and discard
+// it.  A sample_bytes of 0 means GC_PROFILE_DEFAULT_SAMPLE_BYTES.
+void gc_profile_start(size_t sample_bytes);
+void gc_profile_stop(void);
+bool gc_profile_is_active(void);
+
+typedef enum {
+    GC_PROFILE_ALLOCATED,   // all bytes allocated since gc_profile_start
+    GC_PROFILE_LIVE,        // bytes not yet freed
+    GC_PROFILE_SURVIVORS    // bytes not yet freed that survived a collection
+} GCProfileReport;
+
+// Write the given report in folded-stack format (outermost frame first,
+// frames separated by ';', each as "function:pc").  Garbage that has not
+// been swept yet still counts as live, so call gc_collect() first for an
+// exact live report.  Returns the number of lines written, or -1 if the
+// file couldn't be opened.
+int gc_profile_write(const char* path, GCProfileReport report);
+
+// Internal interface for gc.c.  gc_profile_bytes_left counts down as
+// bytes are allocated; when it reaches 0, gc.c calls gc_profile_sample
+// with the new object (which returns true if it was sampled, in which case
+// gc.c must call gc_profile_freed when the object is freed).
+extern long gc_profile_bytes_left;
+bool gc_profile_sample(void* obj, size_t size);
+void gc_profile_freed(void* obj);
+void gc_profile_collection_done(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GC_PROFILE_H
@@ -7,6 +7,7 @@
 #include "value_string.h"
 #include "value_list.h"
 #include "value_map.h"
+#include "value_range.h"
 #include "gc.h"
 #include "StringStorage.h"
 #include <stdio.h>
@@ -55,7 +56,13 @@ Value value_mult_nonnumeric(Value a, Value b) {
             result = string_concat(result, a);
         }
         extraChars = (int)(string_length(a) * (factor - repeats));
-        if (extraChars > 0) result = string_concat(result, string_substring(a, 0, extraChars));
+        if (extraChars > 0) {
+            GC_PUSH_SCOPE();
+            GC_PROTECT(&result);
+            Value extra = string_substring(a, 0, extraChars);
+            result = string_concat(result, extra);
+            GC_POP_SCOPE();
+        }
         return result;
     }
     
@@ -258,6 +265,9 @@ Value to_string(Value v) {
     else if (is_map(v)) {
         return map_to_string(v);
     }
+    else if (is_range(v)) {
+        return range_to_string(v);
+    }
     return val_empty_string;
 }
 
@@ -58,6 +58,7 @@ typedef struct ValueMap {
 // NaN-boxing masks and constants
 #define NANISH_MASK       0xffff000000000000ULL
 #define NULL_VALUE        0xfff1000000000000ULL  // our lowest reserved NaN pattern
+#define RANGE_TAG         0xfff9000000000000ULL
 #define INTEGER_TAG       0xfffa000000000000ULL
 #define FUNCREF_TAG       0xfffb000000000000ULL
 #define MAP_TAG           0xfffc000000000000ULL
@@ -105,6 +106,10 @@ static inline bool is_funcref(Value v) {
     return (v & NANISH_MASK) == FUNCREF_TAG;
 }
 
+static inline bool is_range(Value v) {
+    return (v & NANISH_MASK) == RANGE_TAG;
+}
+
 static inline bool is_list(Value v) {
     return (v & NANISH_MASK) == LIST_TAG;
 }
@@ -148,8 +153,26 @@ typedef struct {
     Value outerVars;      // VarMap containing captured outer variables, or null if none
 } ValueFuncRef;
 
-// Forward declare GC allocation function (implemented in gc.h/.c)
-extern void* gc_allocate(size_t size);
+// Kinds of GC-allocated objects (recorded for heap statistics, and so the GC
+// knows which strings to remove from the intern table; see gc.h)
+typedef enum {
+    GC_TYPE_OTHER,
+    GC_TYPE_STRING,       // StringStorage (heap strings)
+    GC_TYPE_INTERNED_STRING, // StringStorage in the intern table
+    GC_TYPE_LIST,         // ValueList
+    GC_TYPE_MAP,          // ValueMap
+    GC_TYPE_MAP_ENTRIES,  // MapEntry array of a ValueMap
+    GC_TYPE_FUNCREF,      // ValueFuncRef
+    GC_TYPE_VARMAP_DATA,  // VarMapData, and its register-mapping arrays
+    GC_TYPE_RANGE,        // ValueRange
+    GC_TYPE_COUNT
+} GCObjectType;
+
+// Forward declare GC allocation and protection functions (implemented in gc.h/.c)
+extern void* gc_allocate(size_t size, GCObjectType type);
+extern void gc_protect_value(Value* val_ptr);
+extern void gc_push_scope(void);
+extern void gc_pop_scope(void);
 
 // FuncRef accessor functions
 static inline ValueFuncRef* as_funcref(Value v) {
@@ -169,7 +192,10 @@ static inline Value funcref_outer_vars(Value v) {
 
 // FuncRef creation function
 static inline Value make_funcref(int32_t funcIndex, Value outerVars) {
-    ValueFuncRef* funcRefObj = (ValueFuncRef*)gc_allocate(sizeof(ValueFuncRef));
+    gc_push_scope();
+    gc_protect_value(&outerVars);  // (keep the closure context alive while we allocate)
+    ValueFuncRef* funcRefObj = (ValueFuncRef*)gc_allocate(sizeof(ValueFuncRef), GC_TYPE_FUNCREF);
+    gc_pop_scope();
     funcRefObj->funcIndex = funcIndex;
     funcRefObj->outerVars = outerVars;
     return FUNCREF_TAG | ((uintptr_t)funcRefObj & 0xFFFFFFFFFFFFULL);
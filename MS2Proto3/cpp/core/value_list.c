@@ -17,7 +17,7 @@
 // List creation and management
 Value make_list(int initial_capacity) {
     if (initial_capacity <= 0) initial_capacity = 8; // Default capacity
-    ValueList* list = (ValueList*)gc_allocate(sizeof(ValueList) + initial_capacity * sizeof(Value));
+    ValueList* list = (ValueList*)gc_allocate(sizeof(ValueList) + initial_capacity * sizeof(Value), GC_TYPE_LIST);
     list->count = 0;
     list->capacity = initial_capacity;
     return LIST_TAG | ((uintptr_t)list & 0xFFFFFFFFFFFFULL);
@@ -60,6 +60,7 @@ void list_set(Value list_val, int index, Value item) {
     if (index < 0) index += list->count;
     if (index >= 0 && index < list->count) {
         list->items[index] = item;
+        gc_write_barrier(list_val);
     }
 }
 
@@ -70,6 +71,7 @@ void list_push(Value list_val, Value item) {
     // Add item if there's space
     if (list->count < list->capacity) {
         list->items[list->count++] = item;
+        gc_write_barrier(list_val);
     }
     // NOTE: Capacity expansion requires the caller to manage the Value reference
     // since we cannot modify the passed Value. Use list_needs_expansion() and
@@ -99,6 +101,7 @@ void list_insert(Value list_val, int index, Value item) {
     
     list->items[index] = item;
     list->count++;
+    gc_write_barrier(list_val);
 }
 
 bool list_remove(Value list_val, int index) {
@@ -175,7 +178,7 @@ Value list_with_expanded_capacity(Value list_val) {
     if (new_capacity < 2) new_capacity = 2;
     
     // Allocate new list directly to avoid make_list's minimum capacity constraint
-    ValueList* new_list = (ValueList*)gc_allocate(sizeof(ValueList) + new_capacity * sizeof(Value));
+    ValueList* new_list = (ValueList*)gc_allocate(sizeof(ValueList) + new_capacity * sizeof(Value), GC_TYPE_LIST);
     new_list->count = old_list->count;
     new_list->capacity = new_capacity;
     
@@ -225,7 +228,10 @@ Value list_to_string(Value list_val) {
     // Build string: [item1, item2, ...]
     // For now: a simple approach: build each part and concatenate.
     // ToDo: a more efficient approach using Join
+    GC_PUSH_SCOPE();
     Value result = make_string("[");
+    GC_PROTECT(&list_val);
+    GC_PROTECT(&result);
 
     for (int i = 0; i < list->count; i++) {
         if (i > 0) {
@@ -241,5 +247,6 @@ Value list_to_string(Value list_val) {
     Value close = make_string("]");
     result = string_concat(result, close);
 
+    GC_POP_SCOPE();
     return result;
 }
\ No newline at end of file
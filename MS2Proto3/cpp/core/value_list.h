@@ -40,6 +40,16 @@ Value list_pop(Value list_val);
 void list_insert(Value list_val, int index, Value item);
 bool list_remove(Value list_val, int index);
 
+// List iteration, with the iterator state in a single int (so the VM can
+// keep it in a register): start with state 0; each call returns the next
+// state and the item, or -1 (leaving *out_item alone) when there are no more.
+static inline int list_iter_next(Value list_val, int state, Value* out_item) {
+    ValueList* list = (ValueList*)(uintptr_t)(list_val & 0xFFFFFFFFFFFFULL);
+    if (state >= list->count) return -1;
+    *out_item = list->items[state];
+    return state + 1;
+}
+
 // List searching
 int list_indexOf(Value list_val, Value item, int start_pos);
 bool list_contains(Value list_val, Value item);
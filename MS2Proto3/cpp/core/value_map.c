@@ -23,13 +23,21 @@ Value make_map(int initial_capacity) {
     if (initial_capacity <= 0) initial_capacity = 8; // Default capacity
 
     // Allocate the ValueMap structure
-    ValueMap* map = (ValueMap*)gc_allocate(sizeof(ValueMap));
+    ValueMap* map = (ValueMap*)gc_allocate(sizeof(ValueMap), GC_TYPE_MAP);
+    Value result = MAP_TAG | ((uintptr_t)map & 0xFFFFFFFFFFFFULL);
     map->count = 0;
-    map->capacity = initial_capacity;
+    map->capacity = 0;
+    map->entries = NULL;
     map->varmap_data = NULL; // Regular map, no VarMap data
 
-    // Allocate the entries array separately
-    map->entries = (MapEntry*)gc_allocate(initial_capacity * sizeof(MapEntry));
+    // Allocate the entries array separately (protecting the map meanwhile)
+    GC_PUSH_SCOPE();
+    GC_PROTECT(&result);
+    MapEntry* entries = (MapEntry*)gc_allocate(initial_capacity * sizeof(MapEntry), GC_TYPE_MAP_ENTRIES);
+    GC_POP_SCOPE();
+    map->entries = entries;
+    map->capacity = initial_capacity;
+    gc_write_barrier(result);  // (the map may have been promoted meanwhile)
 
     // Initialize all entries as unoccupied
     for (int i = 0; i < initial_capacity; i++) {
@@ -39,7 +47,7 @@ Value make_map(int initial_capacity) {
         map->entries[i].hash = 0;
     }
 
-    return MAP_TAG | ((uintptr_t)map & 0xFFFFFFFFFFFFULL);
+    return result;
 }
 
 Value make_empty_map(void) {
@@ -205,6 +213,7 @@ static bool base_map_set(Value map_val, Value key, Value value) {
 
     // Set or update value
     entry->value = value;
+    gc_write_barrier(map_val);
     return true;
 }
 
@@ -353,7 +362,7 @@ bool map_expand_capacity(Value map_val) {
     MapEntry* old_entries = map->entries;
 
     // Allocate new entries array
-    MapEntry* new_entries = (MapEntry*)gc_allocate(new_capacity * sizeof(MapEntry));
+    MapEntry* new_entries = (MapEntry*)gc_allocate(new_capacity * sizeof(MapEntry), GC_TYPE_MAP_ENTRIES);
     if (!new_entries) return false;
 
     // Initialize new entries
@@ -368,6 +377,7 @@ bool map_expand_capacity(Value map_val) {
     map->entries = new_entries;
     map->capacity = new_capacity;
     map->count = 0; // Will be rebuilt as we re-insert
+    gc_write_barrier(map_val);
 
     // Re-insert all entries from old array
     for (int i = 0; i < old_capacity; i++) {
@@ -454,6 +464,30 @@ bool map_iterator_next(MapIterator* iter, Value* out_key, Value* out_value) {
     return false;
 }
 
+int map_iter_next(Value map_val, int state, Value* out_key, Value* out_value) {
+    // State 0 is the start.  For a VarMap, states 1 through reg_map_count
+    // are just past that register mapping (varmap_reg_index = state - 1);
+    // after those, firstEntryState + 1 + i is just past regular entry i.
+    MapIterator iter = map_iterator(map_val);
+    if (!iter.map) return -1;
+    int firstEntryState = 0;
+    if (iter.map->varmap_data != NULL) {
+        int regCount = iter.map->varmap_data->reg_map_count;
+        firstEntryState = regCount + 1;
+        if (state <= regCount) {
+            iter.varmap_reg_index = state - 1;
+        } else {
+            iter.varmap_reg_index = regCount;
+            iter.index = state - firstEntryState - 1;
+        }
+    } else {
+        iter.index = state - 1;
+    }
+    if (!map_iterator_next(&iter, out_key, out_value)) return -1;
+    if (iter.index < 0) return iter.varmap_reg_index + 1;
+    return firstEntryState + iter.index + 1;
+}
+
 // Hash function for maps
 uint32_t map_hash(Value map_val) {
     ValueMap* map = as_map(map_val);
@@ -489,10 +523,12 @@ Value map_to_string(Value map_val) {
     if (map->count == 0 && map->varmap_data == NULL) return make_string("{}");
 
     // Build string: {"key1": "value1", "key2": "value2"}
+    GC_PUSH_SCOPE();
     Value result = make_string("{");
+    Value key = make_null(), value = make_null(), value_str = make_null();
+    GC_LOCALS(&map_val, &result, &key, &value, &value_str);
 
     MapIterator iter = map_iterator(map_val);
-    Value key, value;
     bool first = true;
 
 	// ToDo: instead of repeatedly calling string_concat, gather all
@@ -505,8 +541,8 @@ Value map_to_string(Value map_val) {
         first = false;
 
         // Get string representation of key and value
+        value_str = value_repr(value);
         Value key_str = value_repr(key);
-        Value value_str = value_repr(value);
 
         // Add "key": "value"
         result = string_concat(result, key_str);
@@ -518,28 +554,28 @@ Value map_to_string(Value map_val) {
     Value close = make_string("}");
     result = string_concat(result, close);
 
+    GC_POP_SCOPE();
     return result;
 }
 
 // VarMap creation and management
 Value make_varmap(Value* registers, Value* names, int firstIndex, int count) {
     // Create regular map structure
-    ValueMap* map = (ValueMap*)gc_allocate(sizeof(ValueMap));
+    ValueMap* map = (ValueMap*)gc_allocate(sizeof(ValueMap), GC_TYPE_MAP);
     Value result = MAP_TAG | ((uintptr_t)map & 0xFFFFFFFFFFFFULL);
     map->count = 0;
+    map->capacity = 0;
+    map->entries = NULL;
+    map->varmap_data = NULL;
+
+    // Keep the map protected while we allocate its parts, and hook each part
+    // up as soon as it exists (so the GC can find it, even if the map itself
+    // got promoted in the meantime)
+    GC_PUSH_SCOPE();
+    GC_PROTECT(&result);
+    map->entries = (MapEntry*)gc_allocate(8 * sizeof(MapEntry), GC_TYPE_MAP_ENTRIES);
     map->capacity = 8;
-    map->entries = (MapEntry*)gc_allocate(8 * sizeof(MapEntry));
-
-    // Allocate and initialize VarMapData
-    VarMapData* vdata = (VarMapData*)gc_allocate(sizeof(VarMapData));
-    vdata->registers = registers;
-    vdata->names = names;
-    vdata->reg_map_keys = (Value*)gc_allocate(5 * sizeof(Value));
-    vdata->reg_map_indices = (int*)gc_allocate(5 * sizeof(int));
-    vdata->reg_map_count = 0;
-    vdata->reg_map_capacity = 5;
-
-    map->varmap_data = vdata;
+    gc_write_barrier(result);
 
     // Initialize map entries
     for (int i = 0; i < 8; i++) {
@@ -548,6 +584,24 @@ Value make_varmap(Value* registers, Value* names, int firstIndex, int count) {
         map->entries[i].value = make_null();
         map->entries[i].hash = 0;
     }
+
+    // Allocate and initialize VarMapData
+    VarMapData* vdata = (VarMapData*)gc_allocate(sizeof(VarMapData), GC_TYPE_VARMAP_DATA);
+    vdata->registers = registers;
+    vdata->names = names;
+    vdata->reg_map_keys = NULL;
+    vdata->reg_map_indices = NULL;
+    vdata->reg_map_count = 0;
+    vdata->reg_map_capacity = 0;
+    map->varmap_data = vdata;
+    gc_write_barrier(result);
+
+    vdata->reg_map_keys = (Value*)gc_allocate(5 * sizeof(Value), GC_TYPE_VARMAP_DATA);
+    gc_write_barrier(result);
+    vdata->reg_map_indices = (int*)gc_allocate(5 * sizeof(int), GC_TYPE_VARMAP_DATA);
+    vdata->reg_map_capacity = 5;
+    gc_write_barrier(result);
+    GC_POP_SCOPE();
     
     for (int i = firstIndex; i < firstIndex + count; i++) {
     	if (!is_null(names[i])) varmap_map_to_register(result, names[i], i);
@@ -566,6 +620,7 @@ void varmap_map_to_register(Value map_val, Value var_name, int reg_index) {
         vdata->reg_map_keys[vdata->reg_map_count] = var_name;
         vdata->reg_map_indices[vdata->reg_map_count] = reg_index;
         vdata->reg_map_count++;
+        gc_write_barrier(map_val);
     }
     // ToDo: else grow our capacity!
 }
@@ -55,6 +55,12 @@ typedef struct {
 MapIterator map_iterator(Value map_val);
 bool map_iterator_next(MapIterator* iter, Value* out_key, Value* out_value);
 
+// The same iteration, but with the MapIterator packed into a single int
+// (so the VM can keep it in a register): start with state 0; each call
+// returns the next state, key, and value, or -1 (leaving *out_key and
+// *out_value alone) when there are no more.
+int map_iter_next(Value map_val, int state, Value* out_key, Value* out_value);
+
 // Hash function for maps
 uint32_t map_hash(Value map_val);
 
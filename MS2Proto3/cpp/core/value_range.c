@@ -0,0 +1,100 @@
+#include "value_range.h"
+#include "value.h"
+#include "value_list.h"
+#include "gc.h"
+#include <math.h>
+#include <limits.h>
+
+#include "layer_defs.h"
+#if LAYER_2A_HIGHER
+#error "value_range.c (Layer 2A) cannot depend on higher layers (3A, 4)"
+#endif
+#if LAYER_2A_BSIDE
+#error "value_range.c (Layer 2A - runtime) cannot depend on B-side layers (2B, 3B)"
+#endif
+
+// Range creation
+Value make_range(Value start, Value stop, Value step) {
+    double startD = is_int(start) ? (double)as_int(start) : as_double(start);
+    double stopD = is_int(stop) ? (double)as_int(stop) : as_double(stop);
+    double stepD;
+    if (is_null(step)) {
+        stepD = (stopD >= startD ? 1 : -1);
+        step = make_int((int32_t)stepD);
+    } else {
+        stepD = is_int(step) ? (double)as_int(step) : as_double(step);
+    }
+
+    ValueRange* range = (ValueRange*)gc_allocate(sizeof(ValueRange), GC_TYPE_RANGE);
+    range->start = startD;
+    range->stop = stopD;
+    range->step = stepD;
+    double count = floor((stopD - startD) / stepD) + 1;
+    if (!(count > 0)) count = 0;  // (also catches NaN)
+    range->count = (count > INT_MAX ? INT_MAX : (int)count);
+    range->ints = is_int(start) && is_int(step);
+    range->list = make_null();
+    return RANGE_TAG | ((uintptr_t)range & 0xFFFFFFFFFFFFULL);
+}
+
+// Range access
+ValueRange* as_range(Value v) {
+    if (!is_range(v)) return NULL;
+    return (ValueRange*)(uintptr_t)(v & 0xFFFFFFFFFFFFULL);
+}
+
+int range_count(Value range_val) {
+    ValueRange* range = as_range(range_val);
+    if (!range) return 0;
+    if (!is_null(range->list)) return list_count(range->list);
+    return range->count;
+}
+
+Value range_get(Value range_val, int index) {
+    ValueRange* range = as_range(range_val);
+    if (!range) return make_null();
+    if (!is_null(range->list)) return list_get(range->list, index);
+    if (index < 0) index += range->count;
+    if (index >= 0 && index < range->count) {
+        return range_element(range, index);
+    }
+    return make_null();
+}
+
+// Make a new list with the range's elements, and room to grow (since
+// list_push can't grow a list in place)
+static Value range_new_list(Value range_val) {
+    // (The list holds only numbers, so nothing here needs protecting from
+    // the GC but the range itself.)
+    GC_PUSH_SCOPE();
+    GC_PROTECT(&range_val);
+    ValueRange* range = as_range(range_val);
+    Value list = make_list(range->count < INT_MAX / 2 ? range->count * 2 : range->count);
+    GC_POP_SCOPE();
+    for (int i = 0; i < range->count; i++) list_push(list, range_element(range, i));
+    return list;
+}
+
+Value range_to_list(Value range_val) {
+    ValueRange* range = as_range(range_val);
+    if (!range) return make_null();
+    if (is_null(range->list)) {
+        Value list = range_new_list(range_val);
+        range->list = list;
+        gc_write_barrier(range_val);
+    }
+    return range->list;
+}
+
+Value range_to_string(Value range_val) {
+    ValueRange* range = as_range(range_val);
+    if (!range) return make_null();
+    if (!is_null(range->list)) return list_to_string(range->list);
+    // (Just a temporary list here; printing a range shouldn't change it)
+    GC_PUSH_SCOPE();
+    Value list = range_new_list(range_val);
+    GC_PROTECT(&list);
+    Value result = list_to_string(list);
+    GC_POP_SCOPE();
+    return result;
+}
@@ -0,0 +1,72 @@
+// Range implementation for NaN-boxed Values.  A range is what range() returns:
+// an evenly spaced sequence of numbers, which acts like a list but is stored
+// as just its start, stop, and step.  (So `for i in range(1, n)` needn't
+// allocate n list items.)  The first change to a range turns it into a real
+// list, which the range then refers to, so every reference to the range sees
+// the change.  All memory management is done via the gc module.
+
+#ifndef VALUE_RANGE_H
+#define VALUE_RANGE_H
+
+#include "value.h"
+#include "value_list.h"
+#include <stdbool.h>
+
+// This module is part of Layer 2A (Runtime Value System + GC)
+#define CORE_LAYER_2A
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Range structure
+typedef struct {
+    double start;    // First element
+    double stop;     // Last element (if step divides stop - start evenly)
+    double step;     // Difference between successive elements (never 0)
+    int count;       // Number of elements
+    bool ints;       // True if start and step are ints (so the elements are too)
+    Value list;      // The list this range has become (see range_to_list), or null
+} ValueRange;
+
+// Range creation: from start to stop inclusive, by step.  All three must be
+// numbers, and step must not be 0 (callers check this); a null step means
+// 1 or -1, whichever way stop lies from start.
+Value make_range(Value start, Value stop, Value step);
+
+// Range access
+ValueRange* as_range(Value v);
+int range_count(Value range_val);
+Value range_get(Value range_val, int index);
+
+// Element `index` (0 <= index < count) of the given range
+static inline Value range_element(ValueRange* range, int index) {
+    double d = range->start + range->step * index;
+    if (range->ints && d >= INT32_MIN && d <= INT32_MAX) return make_int((int32_t)d);
+    return make_double(d);
+}
+
+// Range iteration, with the iterator state in a single int (so the VM can
+// keep it in a register): start with state 0; each call returns the next
+// state and the element, or -1 (leaving *out_item alone) when there are no more.
+static inline int range_iter_next(Value range_val, int state, Value* out_item) {
+    ValueRange* range = (ValueRange*)(uintptr_t)(range_val & 0xFFFFFFFFFFFFULL);
+    if (!is_null(range->list)) return list_iter_next(range->list, state, out_item);
+    if (state >= range->count) return -1;
+    *out_item = range_element(range, state);
+    return state + 1;
+}
+
+// Materialize a range into a list with the same elements (before mutating
+// it).  The range keeps that list and defers to it from then on, so later
+// calls return the same list, and changes to it show through the range.
+Value range_to_list(Value range_val);
+
+// String conversion for runtime (returns GC-managed Value)
+Value range_to_string(Value range_val);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // VALUE_RANGE_H
@@ -22,27 +22,42 @@
 #error "value_string.c (Layer 2A - runtime) cannot depend on B-side layers (2B, 3B)"
 #endif
 
-// String interning system
-#define INTERN_THRESHOLD 128  // Intern strings under 128 bytes
-#define INTERN_TABLE_SIZE 1024  // Hash table size (must be power of 2)
+// String interning system.  The intern table is open-addressed (with linear
+// probing), and grows and shrinks with the number of strings in it.  It holds
+// them weakly: interned strings live in the GC heap like any other, and when
+// one is swept, the GC calls unintern_string to take it out of the table.
+#define INTERN_MIN_CAPACITY 1024  // Smallest table size (must be power of 2)
 
-// Hash table entry for string interning
-typedef struct InternEntry {
-    Value string_value;      // The interned string (heap string Value)
-    struct InternEntry* next;  // Collision chain
-} InternEntry;
+// Global intern table (NULL slots are empty)
+static StringStorage** intern_table = NULL;
+static int intern_capacity = 0;
+static int intern_count = 0;
 
-// Global intern table
-static InternEntry* intern_table[INTERN_TABLE_SIZE];
-static bool intern_table_initialized = false;
+// Rebuild the intern table with the given capacity (a power of 2)
+static void resize_intern_table(int capacity) {
+    StringStorage** old_table = intern_table;
+    int old_capacity = intern_capacity;
+    intern_table = calloc(capacity, sizeof(StringStorage*));
+    intern_capacity = capacity;
+    for (int i = 0; i < old_capacity; i++) {
+        StringStorage* s = old_table[i];
+        if (!s) continue;
+        int slot = s->hash & (capacity - 1);
+        while (intern_table[slot]) slot = (slot + 1) & (capacity - 1);
+        intern_table[slot] = s;
+    }
+    free(old_table);
+}
 
 // Initialize intern table
 static void init_intern_table() {
-    if (intern_table_initialized) return;
-    for (int i = 0; i < INTERN_TABLE_SIZE; i++) {
-        intern_table[i] = NULL;
-    }
-    intern_table_initialized = true;
+    if (intern_table) return;
+    resize_intern_table(INTERN_MIN_CAPACITY);
+}
+
+// Allocator for interned strings (see ss_create)
+static void* intern_allocate(size_t size) {
+    return gc_allocate(size, GC_TYPE_INTERNED_STRING);
 }
 
 // Buffer for tiny string conversion - thread-local would be better in real code
@@ -167,39 +182,58 @@ const char* get_string_data_nullterm(const Value* v_ptr, char* tiny_buffer) {
 static Value find_interned_string(const char* data, int lenB, uint32_t hash) {
     init_intern_table();
     
-    int bucket = hash & (INTERN_TABLE_SIZE - 1);  // hash % table_size
-    InternEntry* entry = intern_table[bucket];
-    
-    while (entry != NULL) {
-        if (is_heap_string(entry->string_value)) {
-            StringStorage* s = as_string(entry->string_value);
-            if (ss_lengthB(s) == lenB && s->hash == hash && memcmp(ss_getCString(s), data, lenB) == 0) {
-                return entry->string_value;  // Found existing interned string
-            }
+    int mask = intern_capacity - 1;
+    for (int slot = hash & mask; intern_table[slot]; slot = (slot + 1) & mask) {
+        StringStorage* s = intern_table[slot];
+        if (s->hash == hash && ss_lengthB(s) == lenB && memcmp(ss_getCString(s), data, lenB) == 0) {
+            // Found it -- unless it's garbage the GC just hasn't swept yet
+            // (then it's as good as gone; a new copy will be made)
+            if (gc_is_dying(s)) continue;
+            return STRING_TAG | ((uintptr_t)s & 0xFFFFFFFFFFFFULL);
         }
-        entry = entry->next;
     }
     
     return make_null();  // Not found
 }
 
 // Add a string to the intern table
-// The string_value must be a heap string with hash already computed
-static void intern_string(Value string_value) {
-    if (!is_heap_string(string_value)) return;
-    
-    StringStorage* s = as_string(string_value);
-    if (s->hash == 0) return;  // Hash must be computed
-    
+// The string must be a heap string with hash already computed
+static void intern_string(StringStorage* s) {
     init_intern_table();
+    if ((intern_count + 1) * 2 > intern_capacity) resize_intern_table(intern_capacity * 2);
+    
+    int mask = intern_capacity - 1;
+    int slot = s->hash & mask;
+    while (intern_table[slot]) slot = (slot + 1) & mask;
+    intern_table[slot] = s;
+    intern_count++;
+}
     
-    int bucket = s->hash & (INTERN_TABLE_SIZE - 1);
+// Remove an interned string from the table (called by the GC when it frees
+// one).  Later entries in the same run are moved up as needed, so that
+// every entry can still be reached from its home slot.
+void unintern_string(StringStorage* s) {
+    if (!intern_table) return;
+    int mask = intern_capacity - 1;
+    int slot = s->hash & mask;
+    while (intern_table[slot] != s) {
+        if (!intern_table[slot]) return;  // (not found)
+        slot = (slot + 1) & mask;
+    }
+    intern_count--;
+    for (int next = (slot + 1) & mask; intern_table[next]; next = (next + 1) & mask) {
+        int home = intern_table[next]->hash & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            intern_table[slot] = intern_table[next];
+            slot = next;
+        }
+    }
+    intern_table[slot] = NULL;
     
-    // Allocate new entry (this is not GC'd - it's part of the intern table)
-    InternEntry* new_entry = malloc(sizeof(InternEntry));
-    new_entry->string_value = string_value;
-    new_entry->next = intern_table[bucket];
-    intern_table[bucket] = new_entry;
+    // Shrink the table if it's now mostly empty
+    if (intern_capacity > INTERN_MIN_CAPACITY && intern_count * 8 < intern_capacity) {
+        resize_intern_table(intern_capacity / 2);
+    }
 }
 
 // Make a Value string from a const char *.  This will create a tiny string,
@@ -224,19 +258,18 @@ Value make_string(const char* str) {
             return existing;
         }
         
-        // Create new interned string with pool allocator (not GC'd - immortal by design)
-		// (ToDo: maybe use a MemPool allocator instead, so we can free them eventually?)
-        StringStorage* s = ss_create(str, malloc);
+        // Create new interned string in the GC heap (it will be removed from
+        // the table when collected)
+        StringStorage* s = ss_create(str, intern_allocate);
         s->hash = hash;  // Store computed hash
-        Value new_string = STRING_TAG | ((uintptr_t)s & 0xFFFFFFFFFFFFULL);
         
         // Add to intern table
-        intern_string(new_string);
+        intern_string(s);
         
-        return new_string;
+        return STRING_TAG | ((uintptr_t)s & 0xFFFFFFFFFFFFULL);
     } else {
         // For longer strings, use regular GC heap allocation
-        StringStorage* s = (StringStorage*)gc_allocate(sizeof(StringStorage) + lenB + 1);
+        StringStorage* s = (StringStorage*)gc_allocate(sizeof(StringStorage) + lenB + 1, GC_TYPE_STRING);
         s->lenB = lenB;
         s->lenC = -1; // Compute character count later when needed
         s->hash = 0;  // ...and same for hash
@@ -299,7 +332,7 @@ Value string_concat(Value a, Value b) {
         result = make_tiny_string(result_buffer, total_lenB);
     } else {
         // Use heap string for longer results
-        StringStorage* result_str = (StringStorage*)gc_allocate(sizeof(StringStorage) + total_lenB + 1);
+        StringStorage* result_str = (StringStorage*)gc_allocate(sizeof(StringStorage) + total_lenB + 1, GC_TYPE_STRING);
         result_str->lenB = total_lenB;
         result_str->lenC = -1;  // Will be computed when needed
         result_str->hash = 0;  // Hash not computed yet
@@ -524,6 +557,18 @@ Value string_split(Value str, Value delimiter) {
     return result;
 }
 
+int string_iter_next(Value str, int state, Value* out_char) {
+    int lenB;
+    const char* data = get_string_data_zerocopy(&str, &lenB);
+    if (!data || state >= lenB) return -1;
+    unsigned char* ptr = (unsigned char*)data + state;
+    UTF8DecodeAndAdvance(&ptr);
+    int charLenB = (int)(ptr - (unsigned char*)data) - state;
+    // (a character is at most 4 bytes, so it always fits in a tiny string)
+    *out_char = make_tiny_string(data + state, charLenB);
+    return state + charLenB;
+}
+
 Value string_substring(Value str, int startIndex, int len) {
     GC_PUSH_SCOPE();
     
@@ -636,25 +681,19 @@ void* value_string_get_intern_table(void) {
     return intern_table;
 }
 
-void* value_string_get_intern_entry_at(int bucket) {
-    if (bucket < 0 || bucket >= INTERN_TABLE_SIZE) return NULL;
-    return intern_table[bucket];
-}
-
-void* value_string_get_next_intern_entry(void* entry) {
-    if (!entry) return NULL;
-    return ((InternEntry*)entry)->next;
+StringStorage* value_string_get_intern_entry_at(int slot) {
+    if (slot < 0 || slot >= intern_capacity) return NULL;
+    return intern_table[slot];
 }
 
-Value value_string_get_entry_value(void* entry) {
-    if (!entry) return make_null();
-    return ((InternEntry*)entry)->string_value;
+int value_string_get_intern_table_size(void) {
+    return intern_capacity;
 }
 
-int value_string_get_intern_table_size(void) {
-    return INTERN_TABLE_SIZE;
+int value_string_get_intern_count(void) {
+    return intern_count;
 }
 
 bool value_string_is_intern_table_initialized(void) {
-    return intern_table_initialized;
+    return intern_table != NULL;
 }
@@ -36,6 +36,11 @@ Value string_replace(Value source, Value search, Value replacement);
 Value string_split(Value str, Value delimiter);
 Value string_substring(Value str, int startIndex, int len);
 
+// String iteration, one character at a time.  The state is the byte offset
+// of the next character (starting at 0); each call returns the next state
+// and the character, or -1 (leaving *out_char alone) when there are no more.
+int string_iter_next(Value str, int state, Value* out_char);
+
 // Zero-copy string data access (for performance-critical operations)
 const char* get_string_data_zerocopy(const Value* v_ptr, int* out_len);
 
@@ -51,12 +56,15 @@ uint32_t string_hash(const char* data, int len);
 // Get or compute hash value for a string
 uint32_t get_string_hash(Value str_val);
 
+// Remove a string from the intern table (called by the GC as it frees an
+// interned string; the table holds its strings weakly)
+void unintern_string(StringStorage* s);
+
 // Accessor functions for debug output (used by gc_debug_output.c)
 void* value_string_get_intern_table(void);
-void* value_string_get_intern_entry_at(int bucket);
-void* value_string_get_next_intern_entry(void* entry);
-Value value_string_get_entry_value(void* entry);
-int value_string_get_intern_table_size(void);
+StringStorage* value_string_get_intern_entry_at(int slot);  // NULL if slot is empty
+int value_string_get_intern_table_size(void);                // (number of slots)
+int value_string_get_intern_count(void);
 bool value_string_is_intern_table_initialized(void);
 
 #ifdef __cplusplus
@@ -8,6 +8,7 @@ using static MiniScript.ValueHelpers;
 // CPP: #include "VM.g.h"
 // CPP: #include "gc.h"
 // CPP: #include "gc_debug_output.h"
+// CPP: #include "gc_profile.h"
 // CPP: #include "value_string.h"
 // CPP: #include "dispatch_macros.h"
 // CPP: #include "VMVis.g.h"
@@ -18,6 +19,9 @@ using static MiniScript.ValueHelpers;
 public class App {
 	public static bool debugMode = false;
 	public static bool visMode = false;
+	public static bool heapProfile = false;
+	public static bool opStats = false;
+	public static bool fuse = true;
 	
 	public static void Main(string[] args) {
 		// CPP: gc_init();
@@ -40,6 +44,13 @@ public class App {
 				debugMode = true;
 			} else if (args[i] == "-vis") {
 				visMode = true;
+			} else if (args[i] == "-heapprof") {
+				heapProfile = true;
+			} else if (args[i] == "-opstats") {
+				opStats = true;
+				fuse = false;	// (profile the code as assembled)
+			} else if (args[i] == "-nofuse") {
+				fuse = false;
 			} else if (!args[i].StartsWith("-")) {
 				// First non-switch argument is the assembly file
 				if (fileArgIndex == -1) fileArgIndex = i;
@@ -48,7 +59,11 @@ public class App {
 		
 		IOHelper.Print("MiniScript 2.0 Prototype 3");
 		/*** BEGIN CPP_ONLY ***
-		#if VM_USE_COMPUTED_GOTO
+		#if VM_USE_TAIL_CALLS
+		#define VARIANT "(tail)"
+		#elif VM_USE_THREADED_CODE
+		#define VARIANT "(threaded)"
+		#elif VM_USE_COMPUTED_GOTO
 		#define VARIANT "(goto)"
 		#else
 		#define VARIANT "(switch)"
@@ -78,6 +93,7 @@ public class App {
 			}
 			
 			if (debugMode) IOHelper.Print(StringUtils.Format("Assembling {0} lines...", lines.Count));
+			// CPP: gc_disable();  // (nothing roots the constants until the VM is set up)
 			Assembler assembler = new Assembler();
 			
 			// Assemble the code, with permanent strings stored in pool 0
@@ -91,6 +107,7 @@ public class App {
 				return; // Bail out rather than trying to run a half-assembled program
 			}
 			
+			if (fuse) assembler.FuseSuperinstructions();
 			if (debugMode) IOHelper.Print("Assembly complete.");
 			
 			// Disassemble and print program (debug only)
@@ -120,7 +137,10 @@ public class App {
 			// Run the program
 			VM vm = new VM();
 			vm.Reset(assembler.Functions);
+			if (opStats) vm.EnableOpcodeProfile();
+			// CPP: gc_enable();
 			Value result = make_null();
+			// CPP: if (heapProfile) gc_profile_start(0);
 			
 			if (visMode) {
 				VMVis vis = new VMVis(vm);
@@ -131,7 +151,15 @@ public class App {
 					if (String.IsNullOrEmpty(cmd)) cmd = "step";
 					if (cmd[0] == 'q') return;
 					if (cmd[0] == 's') {
-						result = vm.Run(1);
+						result = vm.Step();
+						continue;
+					} else if (cmd[0] == 'c') {
+						result = vm.Run();
+						continue;
+					} else if (cmd.StartsWith("b ")) {
+						// Set a breakpoint at the given PC in the current function
+						Int32 breakPC = as_int(to_number(make_string(cmd.Substring(2)))); // CPP: Int32 breakPC = as_int(to_number(make_string(cmd.Substring(2).c_str())));
+						vm.SetBreakpoint(vm.CurrentFunctionIndex(), breakPC);
 						continue;
 					} else if (cmd == "pooldump") {
 						vis.ClearScreen();
@@ -142,6 +170,9 @@ public class App {
 					} else if (cmd == "gcmark") {
 						vis.ClearScreen();
 						IOHelper.Print("GC mark only applies to the C++ version.");  // CPP: gc_mark_and_report();
+					} else if (cmd == "gcstats") {
+						vis.ClearScreen();
+						IOHelper.Print("GC stats only apply to the C++ version.");  // CPP: gc_dump_telemetry();
 					} else if (cmd == "interndump") {
 						vis.ClearScreen();
 						IOHelper.Print("Intern table dump only applies to the C++ version.");  // CPP: dump_intern_table();
@@ -149,9 +180,12 @@ public class App {
 						IOHelper.Print("Available commands:");
 						IOHelper.Print("q[uit] -- Quit to shell");
 						IOHelper.Print("s[tep] -- single-step VM");
+						IOHelper.Print("c[ontinue] -- run until a breakpoint (or the end)");
+						IOHelper.Print("b <pc> -- set a breakpoint at <pc> in the current function");
 						IOHelper.Print("pooldump -- dump all string pool state (C++ only)");
 						IOHelper.Print("gcdump -- dump all GC objects with hex view (C++ only)");
 						IOHelper.Print("gcmark -- run GC mark and show reachable objects (C++ only)");
+						IOHelper.Print("gcstats -- GC telemetry (pauses, recent collections, heap by type) as JSON (C++ only)");
 						IOHelper.Print("interndump -- dump interned strings table (C++ only)");
 					}
 					IOHelper.Input("\n(Press Return.)");
@@ -166,6 +200,27 @@ public class App {
 				IOHelper.Print("\nVM execution complete. Result in r0:");
 				IOHelper.Print(StringUtils.Format("\u001b[1;93m{0}\u001b[0m", result)); // (bold bright yellow)
 			}
+
+			if (opStats) {
+				List<String> report = vm.OpcodeProfileReport(20);
+				for (Int32 i = 0; i < report.Count; i++) IOHelper.Print(report[i]);
+			}
+
+			if (heapProfile) {
+				//*** BEGIN CS_ONLY ***
+				IOHelper.Print("Heap profiling only applies to the C++ version.");
+				//*** END CS_ONLY ***
+				/*** BEGIN CPP_ONLY ***
+				gc_collect();  // (so the live report includes only what's really live)
+				int allocLines = gc_profile_write("heapprof_alloc.folded", GC_PROFILE_ALLOCATED);
+				int liveLines = gc_profile_write("heapprof_live.folded", GC_PROFILE_LIVE);
+				if (allocLines < 0 || liveLines < 0) {
+					IOHelper::Print("Couldn't write heap profile.");
+				} else {
+					IOHelper::Print("Heap profile written to heapprof_alloc.folded and heapprof_live.folded");
+				}
+				*** END CPP_ONLY ***/
+			}
 		}
 		
 		IOHelper.Print("All done!");
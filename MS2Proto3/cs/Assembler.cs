@@ -198,6 +198,7 @@ namespace MiniScript {
 				// ToDo: make simple, consistent conversion functions between String and Value, and use everywhere.
 				Current.ParamNames.Add(make_string(paramName));
 				Current.ParamDefaults.Add(defaultValue);
+				Current.ReserveRegister(Current.ParamNames.Count);	// (parameters start at r1)
 
 				return 0; // Directives don't produce instructions
 			}
@@ -580,6 +581,64 @@ namespace MiniScript {
 
 				instruction = BytecodeUtil.INS_AB(Opcode.BRFALSE_rA_iBC, reg1, (Int16)offset);
 
+			} else if (mnemonic == "FORPREP" || mnemonic == "FORLOOP") {
+				// FORPREP r4, done   (r4 = counter, r5 = limit, r6 = step)
+				// FORLOOP r4, body
+				if (parts.Count != 3) { Error("Syntax error"); return 0; }
+
+				Byte reg1 = ParseRegister(parts[1]);
+				String target = parts[2];
+				Int32 offset;
+
+				// Check if target is a label or a number
+				Int32 labelAddr = FindLabelAddress(target);
+				if (labelAddr >= 0) {
+					// It's a label - calculate relative offset from next instruction
+					offset = labelAddr - (Current.Code.Count + 1);
+				} else {
+					// It's a number
+					offset = ParseInt32(target);
+				}
+				if (offset < Int16.MinValue || offset > Int16.MaxValue) {
+					Error("Range error (Cannot fit branch offset into Int16)"); return 0;
+				}
+
+				Opcode op = (mnemonic == "FORPREP" ? Opcode.FORPREP_rA_iBC : Opcode.FORLOOP_rA_iBC);
+				Current.ReserveRegister(reg1 + 2);	// (the step)
+				instruction = BytecodeUtil.INS_AB(op, reg1, (Int16)offset);
+
+			} else if (mnemonic == "ITER_INIT") {
+				// ITER_INIT r4, r1   (r4 = collection, r5 = state, r6/r7 = element)
+				if (parts.Count != 3) { Error("Syntax error"); return 0; }
+				Byte iterReg = ParseRegister(parts[1]);
+				Byte collReg = ParseRegister(parts[2]);
+				Current.ReserveRegister(iterReg + 3);	// (a map's value)
+				instruction = BytecodeUtil.INS_ABC(Opcode.ITER_INIT_rA_rB, iterReg, collReg, 0);
+
+			} else if (mnemonic == "ITER_NEXT") {
+				// ITER_NEXT r4, body
+				if (parts.Count != 3) { Error("Syntax error"); return 0; }
+
+				Byte reg1 = ParseRegister(parts[1]);
+				String target = parts[2];
+				Int32 offset;
+
+				// Check if target is a label or a number
+				Int32 labelAddr = FindLabelAddress(target);
+				if (labelAddr >= 0) {
+					// It's a label - calculate relative offset from next instruction
+					offset = labelAddr - (Current.Code.Count + 1);
+				} else {
+					// It's a number
+					offset = ParseInt32(target);
+				}
+				if (offset < Int16.MinValue || offset > Int16.MaxValue) {
+					Error("Range error (Cannot fit branch offset into Int16)"); return 0;
+				}
+
+				Current.ReserveRegister(reg1 + 3);
+				instruction = BytecodeUtil.INS_AB(Opcode.ITER_NEXT_rA_iBC, reg1, (Int16)offset);
+
 			} else if (mnemonic == "BRLT") {
 				if (parts.Count != 4) { Error("Syntax error"); return 0; }
 
@@ -833,7 +892,7 @@ namespace MiniScript {
 					instruction = BytecodeUtil.INS(Opcode.ARG_iABC) | (UInt32)(immediate & 0xFFFFFF);
 				}
 
-			} else if (mnemonic == "CALLF") {
+			} else if (mnemonic == "CALLF" || mnemonic == "TAILCALLF") {
 				if (parts.Count != 3) { Error("Syntax error"); return 0; }
 				Byte reserveRegs = (Byte)ParseInt16(parts[1]);	// ToDo: check range before typecast
 				Int16 funcIdx = (Int16)FindFunctionIndex(parts[2]);
@@ -841,7 +900,9 @@ namespace MiniScript {
 					Error(StringUtils.Format("Unknown function: '{0}'", parts[2]));
 					return 0;
 				}
-				instruction = BytecodeUtil.INS_AB(Opcode.CALLF_iA_iBC, reserveRegs, funcIdx);
+				Opcode op = Opcode.CALLF_iA_iBC;
+				if (mnemonic == "TAILCALLF") op = Opcode.TAILCALLF_iA_iBC;
+				instruction = BytecodeUtil.INS_AB(op, reserveRegs, funcIdx);
 
 			} else if (mnemonic == "CALLFN") {
 				if (parts.Count != 3) { Error("Syntax error"); return 0; }
@@ -882,7 +943,9 @@ namespace MiniScript {
 				Error(StringUtils.Format("Invalid register format: '{0}' (expected format: r0, r1, etc.)", reg));
 				return 0;
 			}
-			return (Byte)ParseInt16(reg.Substring(1));
+			Byte result = (Byte)ParseInt16(reg.Substring(1));
+			Current.ReserveRegister(result);	// (every register used is part of the frame)
+			return result;
 		}
 
 		// Helper to parse a Byte number (handles negative numbers)
@@ -1059,6 +1122,7 @@ namespace MiniScript {
 		// (string literals, floating point numbers, or integers too large for Int16)
 		private static Boolean NeedsConstant(String token) {
 			if (IsStringLiteral(token)) return true;
+			if (token == "null") return true;
 			
 			// Check if it contains a decimal point (floating point number)
 			if (token.Contains(".")) return true;
@@ -1090,6 +1154,7 @@ namespace MiniScript {
 				String content = token.Substring(1, token.Length - 2);
 				return make_string(content);
 			}
+			if (token == "null") return make_null();
 			
 			// Check if it contains a decimal point (floating point number).
 			if (token.Contains(".")) {
@@ -1245,6 +1310,9 @@ namespace MiniScript {
 					break;
 				}
 
+				// A .param line is not an instruction
+				if (tokens[0] == ".param") continue;
+
 				// Check if first token is a regular label
 				if (IsLabel(tokens[0])) {
 					String labelName = ParseLabel(tokens[0]);
@@ -1266,9 +1334,493 @@ namespace MiniScript {
 				CurrentLine = sourceLines[i]; // Set current line for error reporting
 				AddLine(sourceLines[i]);
 			}
+
+			// The VM doesn't check for running off the end of the code, so
+			// if this function might, end it with a RETURN.
+			if (!HasError && MayRunOffEnd()) Current.Code.Add(BytecodeUtil.INS(Opcode.RETURN));
+			if (!HasError) FindRegisterNames();
+			if (!HasError) FindMustClear();
 			return endLine;
 		}
 
+		// Whether execution could go past the last instruction of Current:
+		// because that isn't a RETURN, TAILCALLF or JUMP, or an IF could skip it, or a
+		// label points past it.  (Numeric branch offsets are taken on trust.)
+		private Boolean MayRunOffEnd() {
+			List<UInt32> code = Current.Code;
+			Int32 count = code.Count;
+			if (count == 0) return true;
+			Opcode last = (Opcode)BytecodeUtil.OP(code[count-1]);
+			if (last != Opcode.RETURN && last != Opcode.TAILCALLF_iA_iBC && last != Opcode.JUMP_iABC) return true;
+			if (count > 1) {
+				Opcode prev = (Opcode)BytecodeUtil.OP(code[count-2]);
+				if (prev >= Opcode.IFLT_rA_rB && prev <= Opcode.IFNE_rA_iBC) return true;
+			}
+			for (Int32 i = 0; i < _labelAddresses.Count; i++) {
+				if (_labelAddresses[i] >= count) return true;
+			}
+			return false;
+		}
+
+		// Work out what variable name each register of Current has before each
+		// instruction: a call starts with just the parameters named, ASSIGN
+		// and NAME name a register, and LOCALS, OUTER and GLOBALS unname it.
+		// If that never depends on the path taken where it matters (for the
+		// register of a LOADV or LOADC, or any register at a LOCALS or
+		// FUNCREF), record it in Current's RegisterNames and NamedLoads, and
+		// set NamesAreStatic.  Then the VM needn't keep names for this
+		// function as it runs.
+		private void FindRegisterNames() {
+			Current.NamesAreStatic = false;
+			Current.RegisterNames.Clear();
+			Current.NamedLoads.Clear();
+			// (@main's registers are the globals, which any function can get
+			// at with GLOBALS, so the VM always keeps names for those.)
+			if (Current.Name == "@main") return;
+
+			// The state of each register before each instruction is kept in
+			// state[pc * regs + reg]: an index into seen (for a named register),
+			// or -1 (unnamed), or -2 (named or not depending on the path taken).
+			List<UInt32> code = Current.Code;
+			Int32 count = code.Count;
+			Int32 regs = Current.MaxRegs;
+			List<Value> seen = new List<Value>();
+			List<Int32> state = new List<Int32>();
+			List<Boolean> reached = new List<Boolean>();
+			for (Int32 pc = 0; pc < count; pc++) {
+				reached.Add(false);
+				Current.NamedLoads.Add(false);
+				for (Int32 r = 0; r < regs; r++) state.Add(-1);
+			}
+			if (count == 0) return;
+			List<Int32> after = new List<Int32>();
+			for (Int32 r = 0; r < regs; r++) after.Add(-1);
+			for (Int32 i = 0; i < Current.ParamNames.Count && i + 1 < regs; i++) {
+				after[i + 1] = NameIndex(ref seen, Current.ParamNames[i]);
+			}
+			List<Int32> work = new List<Int32>();
+			MergeNames(state, reached, ref work, after, 0);
+
+			// Follow the code from there, until nothing more changes.
+			while (work.Count > 0) {
+				Int32 pc = work[work.Count - 1];
+				work.RemoveAt(work.Count - 1);
+				UInt32 instruction = code[pc];
+				Opcode op = (Opcode)BytecodeUtil.OP(instruction);
+				Byte a = BytecodeUtil.Au(instruction);
+				for (Int32 r = 0; r < regs; r++) after[r] = state[pc * regs + r];
+				if (a < regs) {
+					if (op == Opcode.ASSIGN_rA_rB_kC) {
+						after[a] = NameIndex(ref seen, Current.Constants[BytecodeUtil.Cu(instruction)]);
+					} else if (op == Opcode.NAME_rA_kBC) {
+						after[a] = NameIndex(ref seen, Current.Constants[BytecodeUtil.BCu(instruction)]);
+					} else if (op == Opcode.LOCALS_rA || op == Opcode.OUTER_rA || op == Opcode.GLOBALS_rA) {
+						after[a] = -1;
+					}
+				}
+
+				Boolean fallsThrough = true;
+				Int32 target = BranchTarget(instruction, pc, ref fallsThrough);
+				if (fallsThrough) MergeNames(state, reached, ref work, after, pc + 1);
+				if (target >= 0) MergeNames(state, reached, ref work, after, target);
+			}
+
+			// Then check the places that look at names, and note the answer
+			// for each LOADV and LOADC.
+			for (Int32 pc = 0; pc < count; pc++) {
+				if (!reached[pc]) continue;
+				UInt32 instruction = code[pc];
+				Opcode op = (Opcode)BytecodeUtil.OP(instruction);
+				if (op == Opcode.LOADV_rA_rB_kC || op == Opcode.LOADC_rA_rB_kC) {
+					Byte b = BytecodeUtil.Bu(instruction);
+					if (b >= regs) return;	// (bad code; the VM will reject it)
+					Int32 name = state[pc * regs + b];
+					if (name == -2) return;
+					Current.NamedLoads[pc] = (name >= 0
+					  && value_identical(seen[name], Current.Constants[BytecodeUtil.Cu(instruction)]));
+				} else if (op == Opcode.LOCALS_rA || op == Opcode.FUNCREF_iA_iBC) {
+					for (Int32 r = 0; r < regs; r++) {
+						if (state[pc * regs + r] == -2) return;
+					}
+				}
+			}
+
+			// All good; so make the table, with one entry for each stretch
+			// of code over which a register keeps the same name.
+			for (Int32 r = 0; r < regs; r++) {
+				Int32 name = -1;		// (the register's name from startPC on)
+				Int32 startPC = 0;
+				for (Int32 pc = 0; pc <= count; pc++) {
+					Int32 here = -1;
+					if (pc < count && reached[pc]) here = state[pc * regs + r];
+					if (here == name) continue;
+					if (name >= 0) Current.RegisterNames.Add(new RegisterName((Byte)r, startPC, pc, seen[name]));
+					name = here;
+					startPC = pc;
+				}
+			}
+			Current.NamesAreStatic = true;
+		}
+
+		// Return where the instruction at pc may go other than on to pc + 1:
+		// its branch target, or the instruction an IF may skip to, or for an
+		// ARGBLK, the one after its CALL; or -1 if none.  Also clear
+		// fallsThrough if it can't go on to pc + 1.
+		private static Int32 BranchTarget(UInt32 instruction, Int32 pc, ref Boolean fallsThrough) {
+			Opcode op = (Opcode)BytecodeUtil.OP(instruction);
+			if (op == Opcode.JUMP_iABC) {
+				fallsThrough = false;
+				return pc + 1 + BytecodeUtil.ABCs(instruction);
+			} else if (op == Opcode.RETURN || op == Opcode.TAILCALLF_iA_iBC) {
+				fallsThrough = false;
+			} else if (op == Opcode.ARGBLK_iABC) {
+				fallsThrough = false;
+				return pc + BytecodeUtil.ABCs(instruction) + 2;	// (past its ARGs and CALL)
+			} else if (op == Opcode.BRTRUE_rA_iBC || op == Opcode.BRFALSE_rA_iBC
+			  || op == Opcode.FORPREP_rA_iBC || op == Opcode.FORLOOP_rA_iBC
+			  || op == Opcode.ITER_NEXT_rA_iBC) {
+				return pc + 1 + BytecodeUtil.BCs(instruction);
+			} else if (op >= Opcode.BRLT_rA_rB_iC && op <= Opcode.BRNE_rA_iB_iC) {
+				return pc + 1 + BytecodeUtil.Cs(instruction);
+			} else if (op >= Opcode.IFLT_rA_rB && op <= Opcode.IFNE_rA_iBC) {
+				return pc + 2;
+			}
+			return -1;
+		}
+
+		// Return the index of the given name in seen, adding it if needed.
+		// (By ref, as in C++ a List gets its storage when first added to.)
+		private static Int32 NameIndex(ref List<Value> seen, Value name) {
+			for (Int32 i = 0; i < seen.Count; i++) {
+				if (value_identical(seen[i], name)) return i;
+			}
+			seen.Add(name);
+			return seen.Count - 1;
+		}
+
+		// Merge the given register names (as after some instruction) into
+		// the state before instruction pc (see FindRegisterNames); and if
+		// that changes anything, add pc to the work list.
+		private static void MergeNames(List<Int32> state, List<Boolean> reached, ref List<Int32> work, List<Int32> names, Int32 pc) {
+			if (pc < 0 || pc >= reached.Count) return;
+			Int32 regs = names.Count;
+			Boolean changed = false;
+			for (Int32 r = 0; r < regs; r++) {
+				Int32 i = pc * regs + r;
+				if (!reached[pc]) {
+					state[i] = names[r];
+				} else if (state[i] != names[r] && state[i] != -2) {
+					state[i] = -2;
+					changed = true;
+				}
+			}
+			if (!reached[pc]) changed = true;
+			reached[pc] = true;
+			if (changed) work.Add(pc);
+		}
+
+		// Work out which registers a call to Current must clear (to null)
+		// before it runs: those that, on some path through the code, may be
+		// read before they're written.  The parameters are always set by the
+		// call, so they're left out.  Record them in Current.MustClear, as
+		// runs of consecutive registers.
+		private void FindMustClear() {
+			Current.MustClear.Clear();
+			List<UInt32> code = Current.Code;
+			Int32 count = code.Count;
+			Int32 regs = Current.MaxRegs;
+			Int32 paramCount = Current.ParamNames.Count;
+
+			// Whether each register may be unwritten before each instruction
+			// is kept in unset[pc * regs + reg].
+			List<Boolean> unset = new List<Boolean>();
+			List<Boolean> reached = new List<Boolean>();
+			for (Int32 pc = 0; pc < count; pc++) {
+				reached.Add(false);
+				for (Int32 r = 0; r < regs; r++) unset.Add(false);
+			}
+			List<Boolean> after = new List<Boolean>();
+			List<Boolean> reads = new List<Boolean>();
+			List<Boolean> writes = new List<Boolean>();
+			List<Boolean> mustClear = new List<Boolean>();
+			for (Int32 r = 0; r < regs; r++) {
+				after.Add(r == 0 || r > paramCount);
+				reads.Add(false);
+				writes.Add(false);
+				mustClear.Add(false);
+			}
+			List<Int32> work = new List<Int32>();
+			MergeUnset(unset, reached, ref work, after, 0);
+
+			// Follow the code from there, until nothing more changes, noting
+			// each register read where it may be unwritten.
+			while (work.Count > 0) {
+				Int32 pc = work[work.Count - 1];
+				work.RemoveAt(work.Count - 1);
+				UInt32 instruction = code[pc];
+				RegisterUse(code, pc, reads, writes);
+				for (Int32 r = 0; r < regs; r++) {
+					if (reads[r] && unset[pc * regs + r]) mustClear[r] = true;
+					after[r] = unset[pc * regs + r] && !writes[r];
+				}
+
+				Boolean fallsThrough = true;
+				Int32 target = BranchTarget(instruction, pc, ref fallsThrough);
+				if (fallsThrough) MergeUnset(unset, reached, ref work, after, pc + 1);
+				if ((Opcode)BytecodeUtil.OP(instruction) == Opcode.ITER_NEXT_rA_iBC) {
+					// (which writes the state and element only when it branches)
+					MarkRegisters(after, BytecodeUtil.Au(instruction) + 1, BytecodeUtil.Au(instruction) + 2, false);
+				}
+				if (target >= 0) MergeUnset(unset, reached, ref work, after, target);
+			}
+
+			for (Int32 r = 0; r < regs; r++) {
+				if (!mustClear[r] || (r > 0 && mustClear[r - 1])) continue;
+				Int32 end = r + 1;
+				while (end < regs && mustClear[end]) end++;
+				Current.MustClear.Add(new RegisterRun((Byte)r, end));
+			}
+			Current.MustClearIsKnown = true;
+		}
+
+		// Find which registers the instruction at pc may read (set in reads),
+		// and which it always writes (set in writes).  An ARGBLK stands for
+		// its whole block, up to and including its CALL.  Where we can't tell
+		// just what an instruction reads, we assume the worst.
+		private static void RegisterUse(List<UInt32> code, Int32 pc, List<Boolean> reads, List<Boolean> writes) {
+			Int32 regs = reads.Count;
+			MarkRegisters(reads, 0, regs - 1, false);
+			MarkRegisters(writes, 0, regs - 1, false);
+			UInt32 instruction = code[pc];
+			Opcode op = (Opcode)BytecodeUtil.OP(instruction);
+			Int32 a = BytecodeUtil.Au(instruction);
+			Int32 b = BytecodeUtil.Bu(instruction);
+			Int32 c = BytecodeUtil.Cu(instruction);
+			switch (op) {
+				case Opcode.NOOP:
+				case Opcode.NAME_rA_kBC:
+				case Opcode.JUMP_iABC:
+					break;
+
+				case Opcode.LOAD_rA_iBC:
+				case Opcode.LOAD_rA_kBC:
+				case Opcode.LIST_rA_iBC:
+				case Opcode.MAP_rA_iBC:
+				case Opcode.OUTER_rA:
+				case Opcode.GLOBALS_rA:
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.LOAD_rA_rB:
+				case Opcode.LOADV_rA_rB_kC:
+				case Opcode.LOADC_rA_rB_kC:
+				case Opcode.ASSIGN_rA_rB_kC:
+				case Opcode.LT_rA_rB_iC:
+				case Opcode.LE_rA_rB_iC:
+				case Opcode.EQ_rA_rB_iC:
+				case Opcode.NE_rA_rB_iC:
+					MarkRegisters(reads, b, b, true);
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.LT_rA_iB_rC:
+				case Opcode.LE_rA_iB_rC:
+					MarkRegisters(reads, c, c, true);
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.ADD_rA_rB_rC:
+				case Opcode.SUB_rA_rB_rC:
+				case Opcode.MULT_rA_rB_rC:
+				case Opcode.DIV_rA_rB_rC:
+				case Opcode.MOD_rA_rB_rC:
+				case Opcode.INDEX_rA_rB_rC:
+				case Opcode.LT_rA_rB_rC:
+				case Opcode.LE_rA_rB_rC:
+				case Opcode.EQ_rA_rB_rC:
+				case Opcode.NE_rA_rB_rC:
+					MarkRegisters(reads, b, b, true);
+					MarkRegisters(reads, c, c, true);
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.PUSH_rA_rB:
+				case Opcode.BRLT_rA_rB_iC:
+				case Opcode.BRLE_rA_rB_iC:
+				case Opcode.BREQ_rA_rB_iC:
+				case Opcode.BRNE_rA_rB_iC:
+				case Opcode.IFLT_rA_rB:
+				case Opcode.IFLE_rA_rB:
+				case Opcode.IFEQ_rA_rB:
+				case Opcode.IFNE_rA_rB:
+					MarkRegisters(reads, a, a, true);
+					MarkRegisters(reads, b, b, true);
+					break;
+
+				case Opcode.IDXSET_rA_rB_rC:
+					MarkRegisters(reads, a, a, true);
+					MarkRegisters(reads, b, b, true);
+					MarkRegisters(reads, c, c, true);
+					break;
+
+				case Opcode.BRTRUE_rA_iBC:
+				case Opcode.BRFALSE_rA_iBC:
+				case Opcode.BRLT_rA_iB_iC:
+				case Opcode.BRLE_rA_iB_iC:
+				case Opcode.BREQ_rA_iB_iC:
+				case Opcode.BRNE_rA_iB_iC:
+				case Opcode.IFLT_rA_iBC:
+				case Opcode.IFLE_rA_iBC:
+				case Opcode.IFEQ_rA_iBC:
+				case Opcode.IFNE_rA_iBC:
+					MarkRegisters(reads, a, a, true);
+					break;
+
+				case Opcode.BRLT_iA_rB_iC:
+				case Opcode.BRLE_iA_rB_iC:
+					MarkRegisters(reads, b, b, true);
+					break;
+
+				case Opcode.IFLT_iAB_rC:
+				case Opcode.IFLE_iAB_rC:
+					MarkRegisters(reads, c, c, true);
+					break;
+
+				case Opcode.FORPREP_rA_iBC:
+				case Opcode.FORLOOP_rA_iBC:
+					MarkRegisters(reads, a, a + 2, true);
+					break;
+
+				case Opcode.ITER_INIT_rA_rB:
+					MarkRegisters(reads, b, b, true);
+					MarkRegisters(writes, a, a + 1, true);
+					break;
+
+				case Opcode.ITER_NEXT_rA_iBC:
+					MarkRegisters(reads, a, a + 1, true);
+					break;
+
+				case Opcode.ARGBLK_iABC: {
+					// Each ARG may read a register, and the CALL reads the
+					// funcref and writes the result.  (The callee clears its
+					// own registers.)
+					Int32 argCount = BytecodeUtil.ABCs(instruction);
+					for (Int32 i = 1; i <= argCount && pc + i < code.Count; i++) {
+						UInt32 arg = code[pc + i];
+						if ((Opcode)BytecodeUtil.OP(arg) == Opcode.ARG_rA) {
+							MarkRegisters(reads, BytecodeUtil.Au(arg), BytecodeUtil.Au(arg), true);
+						}
+					}
+					if (pc + argCount + 1 < code.Count) {
+						UInt32 call = code[pc + argCount + 1];
+						MarkRegisters(reads, BytecodeUtil.Cu(call), BytecodeUtil.Cu(call), true);
+						MarkRegisters(writes, BytecodeUtil.Au(call), BytecodeUtil.Au(call), true);
+					}
+					break;
+				}
+
+				case Opcode.CALL_rA_rB_rC:
+					MarkRegisters(reads, c, c, true);
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.CALLF_iA_iBC:
+				case Opcode.CALLFN_iA_kBC:
+				case Opcode.TAILCALLF_iA_iBC:
+					// The callee's registers are ours from A on, and CALLF
+					// doesn't clear them; so it may read any of those.
+					MarkRegisters(reads, a, regs - 1, true);
+					MarkRegisters(writes, a, a, true);
+					break;
+
+				case Opcode.RETURN:
+					MarkRegisters(reads, 0, 0, true);
+					break;
+
+				default:
+					// LOCALS and FUNCREF make a VarMap that can read any
+					// register; and anything else, we don't know.
+					MarkRegisters(reads, 0, regs - 1, true);
+					if (op == Opcode.LOCALS_rA || op == Opcode.FUNCREF_iA_iBC) MarkRegisters(writes, a, a, true);
+					break;
+			}
+		}
+
+		// Set registers first through last (as far as there are any) in the
+		// given set to the given value.
+		private static void MarkRegisters(List<Boolean> set, Int32 first, Int32 last, Boolean value) {
+			for (Int32 r = first; r <= last && r < set.Count; r++) set[r] = value;
+		}
+
+		// Merge the given unwritten registers (as after some instruction) into
+		// the state before instruction pc (see FindMustClear); and if that
+		// changes anything, add pc to the work list.
+		private static void MergeUnset(List<Boolean> unset, List<Boolean> reached, ref List<Int32> work, List<Boolean> after, Int32 pc) {
+			if (pc < 0 || pc >= reached.Count) return;
+			Int32 regs = after.Count;
+			Boolean changed = !reached[pc];
+			for (Int32 r = 0; r < regs; r++) {
+				Int32 i = pc * regs + r;
+				if (after[r] && !unset[i]) {
+					unset[i] = true;
+					changed = true;
+				}
+			}
+			reached[pc] = true;
+			if (changed) work.Add(pc);
+		}
+
+		// Post-assembly pass: find the instruction sequences that dominate
+		// opcode-pair profiles (see VM.EnableOpcodeProfile), and replace the
+		// first instruction of each with a superinstruction that does the
+		// whole sequence in one dispatch.  The rest of the sequence is left
+		// as it was, so code size and branch offsets don't change, and a
+		// branch into the middle of a sequence still works.
+		public void FuseSuperinstructions() {
+			for (Int32 f = 0; f < Functions.Count; f++) {
+				List<UInt32> code = Functions[f].Code;
+				Int32 i = 0;
+				while (i < code.Count) {
+					Opcode fused = FindSuperinstruction(code, i);
+					if (fused != Opcode.NOOP) {
+						code[i] = BytecodeUtil.WithOP(code[i], fused);
+						i += BytecodeUtil.FusedLength(fused);
+					} else {
+						i++;
+					}
+				}
+			}
+		}
+
+		// Return the superinstruction that can replace code[i] (along with
+		// the instructions after it), or NOOP if there is none.
+		private static Opcode FindSuperinstruction(List<UInt32> code, Int32 i) {
+			if (i + 1 >= code.Count) return Opcode.NOOP;
+			UInt32 ins0 = code[i];
+			UInt32 ins1 = code[i+1];
+			Opcode op0 = (Opcode)BytecodeUtil.OP(ins0);
+			Opcode op1 = (Opcode)BytecodeUtil.OP(ins1);
+
+			if (op0 == Opcode.ADD_rA_rB_rC) {
+				if (op1 == Opcode.BRLT_rA_rB_iC) return Opcode.ADD_BRLT;
+				if (op1 == Opcode.BRLE_rA_rB_iC) return Opcode.ADD_BRLE;
+				return Opcode.NOOP;
+			}
+
+			if (op0 != Opcode.LOAD_rA_iBC || i + 2 >= code.Count) return Opcode.NOOP;
+			Opcode op2 = (Opcode)BytecodeUtil.OP(code[i+2]);
+			Byte loaded = BytecodeUtil.Au(ins0);
+
+			// LOAD rX, n; IFLT rA, rX; RETURN
+			if (op1 == Opcode.IFLT_rA_rB && BytecodeUtil.Bu(ins1) == loaded
+					&& op2 == Opcode.RETURN) return Opcode.IFLTI_RET;
+
+			// LOAD rX, n; SUB rA, rB, rX; CALLF
+			if (op1 == Opcode.SUB_rA_rB_rC && BytecodeUtil.Cu(ins1) == loaded
+					&& op2 == Opcode.CALLF_iA_iBC) return Opcode.SUBI_CALLF;
+
+			return Opcode.NOOP;
+		}
 
 	}
 }
@@ -64,9 +64,43 @@ namespace MiniScript {
 		ARG_rA,
 		ARG_iABC,
 		CALLF_iA_iBC,
+		TAILCALLF_iA_iBC,
 		CALLFN_iA_kBC,
 		CALL_rA_rB_rC,
 		RETURN,
+		FORPREP_rA_iBC,
+		FORLOOP_rA_iBC,
+		ITER_INIT_rA_rB,
+		ITER_NEXT_rA_iBC,
+		// Quickened forms.  The assembler never emits these; the VM rewrites
+		// a generic instruction into one of them when it sees the operand
+		// types it's specialized for, and back again when it sees others.
+		ADD_INT_rA_rB_rC,
+		ADD_DBL_rA_rB_rC,
+		SUB_INT_rA_rB_rC,
+		SUB_DBL_rA_rB_rC,
+		MULT_INT_rA_rB_rC,
+		MULT_DBL_rA_rB_rC,
+		LT_INT_rA_rB_rC,
+		LE_INT_rA_rB_rC,
+		BRLT_INT_rA_rB_iC,
+		BRLT_INT_rA_iB_iC,
+		BRLE_INT_rA_rB_iC,
+		BRLE_INT_rA_iB_iC,
+		IFLT_INT_rA_rB,
+		IFLT_INT_rA_iBC,
+		IFLE_INT_rA_rB,
+		IFLE_INT_rA_iBC,
+		// Superinstructions.  The assembler never emits these either; the
+		// fusion pass (Assembler.FuseSuperinstructions) puts one in place of
+		// the first instruction of a common sequence, leaving the rest of the
+		// sequence in place (so branch offsets don't change).  The VM then
+		// does the whole sequence in one dispatch, reading the operands of
+		// the following instructions from the code.  See FusedLength.
+		IFLTI_RET,		// LOAD rX, n; IFLT rA, rX; RETURN
+		SUBI_CALLF,		// LOAD rX, n; SUB rA, rB, rX; CALLF
+		ADD_BRLT,		// ADD rA, rB, rC; BRLT rD, rE, offset
+		ADD_BRLE,		// ADD rA, rB, rC; BRLE rD, rE, offset
 		OP__COUNT  // Not an opcode, but rather how many opcodes we have.
 	}
 
@@ -106,6 +140,33 @@ namespace MiniScript {
 		public static UInt32 INS_AB(Opcode op, Byte a, Int16 bc) => (UInt32)(((Byte)op << 24) | (a << 16) | ((UInt16)bc));
 		public static UInt32 INS_BC(Opcode op, Int16 ab, Byte c) => (UInt32)(((Byte)op << 24) | ((UInt16)ab << 8) | c); // Note: ab is casted to (UInt16) instead of (Int16) in the encoding to avoid padding with 1's which overwrites the opcode. We could also use & instead.
 		public static UInt32 INS_ABC(Opcode op, Byte a, Byte b, Byte c) => (UInt32)(((Byte)op << 24) | (a << 16) | (b << 8) | c);
+
+		// Replace just the opcode of an instruction, keeping its operands
+		public static UInt32 WithOP(UInt32 instruction, Opcode op) => ((UInt32)(Byte)op << 24) | (instruction & 0xFFFFFF);
+
+		// How many instructions the given opcode stands for: 1, except for
+		// a superinstruction, which covers itself plus the following ones.
+		public static Int32 FusedLength(Opcode op) {
+			switch (op) {
+				case Opcode.IFLTI_RET:  return 3;
+				case Opcode.SUBI_CALLF: return 3;
+				case Opcode.ADD_BRLT:   return 2;
+				case Opcode.ADD_BRLE:   return 2;
+				default:                return 1;
+			}
+		}
+
+		// The opcode a superinstruction replaced (i.e., the opcode that goes
+		// with its own operands); any other opcode is returned unchanged.
+		public static Opcode UnfusedOP(Opcode op) {
+			switch (op) {
+				case Opcode.IFLTI_RET:  return Opcode.LOAD_rA_iBC;
+				case Opcode.SUBI_CALLF: return Opcode.LOAD_rA_iBC;
+				case Opcode.ADD_BRLT:   return Opcode.ADD_rA_rB_rC;
+				case Opcode.ADD_BRLE:   return Opcode.ADD_rA_rB_rC;
+				default:                return op;
+			}
+		}
 		
 		// Conversion to/from opcode mnemonics (names)
 		public static String ToMnemonic(Opcode opcode) {
@@ -169,9 +230,34 @@ namespace MiniScript {
 				case Opcode.ARG_rA:         return "ARG_rA";
 				case Opcode.ARG_iABC:       return "ARG_iABC";
 				case Opcode.CALLF_iA_iBC:   return "CALLF_iA_iBC";
+				case Opcode.TAILCALLF_iA_iBC: return "TAILCALLF_iA_iBC";
 				case Opcode.CALLFN_iA_kBC:  return "CALLFN_iA_kBC";
 				case Opcode.CALL_rA_rB_rC:  return "CALL_rA_rB_rC";
 				case Opcode.RETURN:         return "RETURN";
+				case Opcode.FORPREP_rA_iBC: return "FORPREP_rA_iBC";
+				case Opcode.FORLOOP_rA_iBC: return "FORLOOP_rA_iBC";
+				case Opcode.ITER_INIT_rA_rB:  return "ITER_INIT_rA_rB";
+				case Opcode.ITER_NEXT_rA_iBC: return "ITER_NEXT_rA_iBC";
+				case Opcode.ADD_INT_rA_rB_rC:  return "ADD_INT_rA_rB_rC";
+				case Opcode.ADD_DBL_rA_rB_rC:  return "ADD_DBL_rA_rB_rC";
+				case Opcode.SUB_INT_rA_rB_rC:  return "SUB_INT_rA_rB_rC";
+				case Opcode.SUB_DBL_rA_rB_rC:  return "SUB_DBL_rA_rB_rC";
+				case Opcode.MULT_INT_rA_rB_rC: return "MULT_INT_rA_rB_rC";
+				case Opcode.MULT_DBL_rA_rB_rC: return "MULT_DBL_rA_rB_rC";
+				case Opcode.LT_INT_rA_rB_rC:   return "LT_INT_rA_rB_rC";
+				case Opcode.LE_INT_rA_rB_rC:   return "LE_INT_rA_rB_rC";
+				case Opcode.BRLT_INT_rA_rB_iC: return "BRLT_INT_rA_rB_iC";
+				case Opcode.BRLT_INT_rA_iB_iC: return "BRLT_INT_rA_iB_iC";
+				case Opcode.BRLE_INT_rA_rB_iC: return "BRLE_INT_rA_rB_iC";
+				case Opcode.BRLE_INT_rA_iB_iC: return "BRLE_INT_rA_iB_iC";
+				case Opcode.IFLT_INT_rA_rB:    return "IFLT_INT_rA_rB";
+				case Opcode.IFLT_INT_rA_iBC:   return "IFLT_INT_rA_iBC";
+				case Opcode.IFLE_INT_rA_rB:    return "IFLE_INT_rA_rB";
+				case Opcode.IFLE_INT_rA_iBC:   return "IFLE_INT_rA_iBC";
+				case Opcode.IFLTI_RET:         return "IFLTI_RET";
+				case Opcode.SUBI_CALLF:        return "SUBI_CALLF";
+				case Opcode.ADD_BRLT:          return "ADD_BRLT";
+				case Opcode.ADD_BRLE:          return "ADD_BRLE";
 				default:
 					return "Unknown opcode";
 			}
@@ -237,9 +323,34 @@ namespace MiniScript {
 			if (s == "ARG_rA")          return Opcode.ARG_rA;
 			if (s == "ARG_iABC")        return Opcode.ARG_iABC;
 			if (s == "CALLF_iA_iBC")    return Opcode.CALLF_iA_iBC;
+			if (s == "TAILCALLF_iA_iBC") return Opcode.TAILCALLF_iA_iBC;
 			if (s == "CALLFN_iA_kBC")   return Opcode.CALLFN_iA_kBC;
 			if (s == "CALL_rA_rB_rC")   return Opcode.CALL_rA_rB_rC;
 			if (s == "RETURN")          return Opcode.RETURN;
+			if (s == "FORPREP_rA_iBC")  return Opcode.FORPREP_rA_iBC;
+			if (s == "FORLOOP_rA_iBC")  return Opcode.FORLOOP_rA_iBC;
+			if (s == "ITER_INIT_rA_rB")  return Opcode.ITER_INIT_rA_rB;
+			if (s == "ITER_NEXT_rA_iBC") return Opcode.ITER_NEXT_rA_iBC;
+			if (s == "ADD_INT_rA_rB_rC")  return Opcode.ADD_INT_rA_rB_rC;
+			if (s == "ADD_DBL_rA_rB_rC")  return Opcode.ADD_DBL_rA_rB_rC;
+			if (s == "SUB_INT_rA_rB_rC")  return Opcode.SUB_INT_rA_rB_rC;
+			if (s == "SUB_DBL_rA_rB_rC")  return Opcode.SUB_DBL_rA_rB_rC;
+			if (s == "MULT_INT_rA_rB_rC") return Opcode.MULT_INT_rA_rB_rC;
+			if (s == "MULT_DBL_rA_rB_rC") return Opcode.MULT_DBL_rA_rB_rC;
+			if (s == "LT_INT_rA_rB_rC")   return Opcode.LT_INT_rA_rB_rC;
+			if (s == "LE_INT_rA_rB_rC")   return Opcode.LE_INT_rA_rB_rC;
+			if (s == "BRLT_INT_rA_rB_iC") return Opcode.BRLT_INT_rA_rB_iC;
+			if (s == "BRLT_INT_rA_iB_iC") return Opcode.BRLT_INT_rA_iB_iC;
+			if (s == "BRLE_INT_rA_rB_iC") return Opcode.BRLE_INT_rA_rB_iC;
+			if (s == "BRLE_INT_rA_iB_iC") return Opcode.BRLE_INT_rA_iB_iC;
+			if (s == "IFLT_INT_rA_rB")    return Opcode.IFLT_INT_rA_rB;
+			if (s == "IFLT_INT_rA_iBC")   return Opcode.IFLT_INT_rA_iBC;
+			if (s == "IFLE_INT_rA_rB")    return Opcode.IFLE_INT_rA_rB;
+			if (s == "IFLE_INT_rA_iBC")   return Opcode.IFLE_INT_rA_iBC;
+			if (s == "IFLTI_RET")         return Opcode.IFLTI_RET;
+			if (s == "SUBI_CALLF")        return Opcode.SUBI_CALLF;
+			if (s == "ADD_BRLT")          return Opcode.ADD_BRLT;
+			if (s == "ADD_BRLE")          return Opcode.ADD_BRLE;
 			return Opcode.NOOP;
 		}
 	}
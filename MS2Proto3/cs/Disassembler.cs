@@ -71,9 +71,34 @@ namespace MiniScript {
 				case Opcode.ARG_rA:
 				case Opcode.ARG_iABC:      return "ARG";
 				case Opcode.CALLF_iA_iBC:  return "CALLF";
+				case Opcode.TAILCALLF_iA_iBC: return "TAILCALLF";
 				case Opcode.CALLFN_iA_kBC: return "CALLFN";
 				case Opcode.CALL_rA_rB_rC: return "CALL";
 				case Opcode.RETURN:        return "RETURN";
+				case Opcode.FORPREP_rA_iBC: return "FORPREP";
+				case Opcode.FORLOOP_rA_iBC: return "FORLOOP";
+				case Opcode.ITER_INIT_rA_rB:  return "ITER_INIT";
+				case Opcode.ITER_NEXT_rA_iBC: return "ITER_NEXT";
+				case Opcode.ADD_INT_rA_rB_rC:  return "ADD_INT";
+				case Opcode.ADD_DBL_rA_rB_rC:  return "ADD_DBL";
+				case Opcode.SUB_INT_rA_rB_rC:  return "SUB_INT";
+				case Opcode.SUB_DBL_rA_rB_rC:  return "SUB_DBL";
+				case Opcode.MULT_INT_rA_rB_rC: return "MULT_INT";
+				case Opcode.MULT_DBL_rA_rB_rC: return "MULT_DBL";
+				case Opcode.LT_INT_rA_rB_rC:   return "LT_INT";
+				case Opcode.LE_INT_rA_rB_rC:   return "LE_INT";
+				case Opcode.BRLT_INT_rA_rB_iC:
+				case Opcode.BRLT_INT_rA_iB_iC: return "BRLT_INT";
+				case Opcode.BRLE_INT_rA_rB_iC:
+				case Opcode.BRLE_INT_rA_iB_iC: return "BRLE_INT";
+				case Opcode.IFLT_INT_rA_rB:
+				case Opcode.IFLT_INT_rA_iBC:   return "IFLT_INT";
+				case Opcode.IFLE_INT_rA_rB:
+				case Opcode.IFLE_INT_rA_iBC:   return "IFLE_INT";
+				case Opcode.IFLTI_RET:         return "IFLTI_RET";
+				case Opcode.SUBI_CALLF:        return "SUBI_CALLF";
+				case Opcode.ADD_BRLT:          return "ADD_BRLT";
+				case Opcode.ADD_BRLE:          return "ADD_BRLE";
 				default:
 					return "Unknown opcode";
 			}		
@@ -81,8 +106,16 @@ namespace MiniScript {
 		
 		public static String ToString(UInt32 instruction) {
 			Opcode opcode = (Opcode)BytecodeUtil.OP(instruction);
+			if (BytecodeUtil.FusedLength(opcode) > 1) {
+				// Superinstruction: show the instruction it replaced, and note
+				// the fusion (the rest of the sequence follows as usual)
+				Opcode unfused = BytecodeUtil.UnfusedOP(opcode);
+				return StringUtils.Format("{0} [{1}]",
+					ToString(BytecodeUtil.WithOP(instruction, unfused)),
+					AssemOp(opcode));
+			}
 			String mnemonic = AssemOp(opcode);
-			mnemonic = (mnemonic + "     ").Left(7);
+			if (mnemonic.Length < 7) mnemonic = (mnemonic + "     ").Left(7);
 			
 			// In the following switch, we group opcodes according
 			// to their operand usage.
@@ -114,6 +147,9 @@ namespace MiniScript {
 				case Opcode.IFLE_rA_rB:
 				case Opcode.IFEQ_rA_rB:
 				case Opcode.IFNE_rA_rB:
+				case Opcode.IFLT_INT_rA_rB:
+				case Opcode.IFLE_INT_rA_rB:
+				case Opcode.ITER_INIT_rA_rB:
 					return StringUtils.Format("{0} r{1}, r{2}",
 						mnemonic,
 						(Int32)BytecodeUtil.Au(instruction),
@@ -134,8 +170,13 @@ namespace MiniScript {
 				case Opcode.IFLE_rA_iBC:
 				case Opcode.IFEQ_rA_iBC:
 				case Opcode.IFNE_rA_iBC:
+				case Opcode.IFLT_INT_rA_iBC:
+				case Opcode.IFLE_INT_rA_iBC:
 				case Opcode.BRTRUE_rA_iBC:
 				case Opcode.BRFALSE_rA_iBC:
+				case Opcode.FORPREP_rA_iBC:
+				case Opcode.FORLOOP_rA_iBC:
+				case Opcode.ITER_NEXT_rA_iBC:
         			return StringUtils.Format("{0} r{1}, {2}",
         				mnemonic,
         				(Int32)BytecodeUtil.Au(instruction),
@@ -160,6 +201,7 @@ namespace MiniScript {
         				(Int32)BytecodeUtil.Au(instruction));
         		// iA, iBC
 				case Opcode.CALLF_iA_iBC:
+				case Opcode.TAILCALLF_iA_iBC:
         			return StringUtils.Format("{0} {1}, {2}",
         				mnemonic,
         				(Int32)BytecodeUtil.As(instruction),
@@ -186,6 +228,14 @@ namespace MiniScript {
 				case Opcode.INDEX_rA_rB_rC:
 				case Opcode.IDXSET_rA_rB_rC:
 				case Opcode.CALL_rA_rB_rC:
+				case Opcode.ADD_INT_rA_rB_rC:
+				case Opcode.ADD_DBL_rA_rB_rC:
+				case Opcode.SUB_INT_rA_rB_rC:
+				case Opcode.SUB_DBL_rA_rB_rC:
+				case Opcode.MULT_INT_rA_rB_rC:
+				case Opcode.MULT_DBL_rA_rB_rC:
+				case Opcode.LT_INT_rA_rB_rC:
+				case Opcode.LE_INT_rA_rB_rC:
         			return StringUtils.Format("{0} r{1}, r{2}, r{3}",
         				mnemonic,
         				(Int32)BytecodeUtil.Au(instruction),
@@ -200,6 +250,8 @@ namespace MiniScript {
 				case Opcode.BRLE_rA_rB_iC:
 				case Opcode.BREQ_rA_rB_iC:
 				case Opcode.BRNE_rA_rB_iC:
+				case Opcode.BRLT_INT_rA_rB_iC:
+				case Opcode.BRLE_INT_rA_rB_iC:
 					return StringUtils.Format("{0} r{1}, r{2}, {3}",
         				mnemonic,
         				(Int32)BytecodeUtil.Au(instruction),
@@ -210,6 +262,8 @@ namespace MiniScript {
 				case Opcode.BRLE_rA_iB_iC:
 				case Opcode.BREQ_rA_iB_iC:
 				case Opcode.BRNE_rA_iB_iC:
+				case Opcode.BRLT_INT_rA_iB_iC:
+				case Opcode.BRLE_INT_rA_iB_iC:
 					return StringUtils.Format("{0} r{1}, {2}, {3}",
         				mnemonic,
         				(Int32)BytecodeUtil.Au(instruction),
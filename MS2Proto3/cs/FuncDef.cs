@@ -6,6 +6,35 @@ using static MiniScript.ValueHelpers;
 
 namespace MiniScript {
 
+	// One entry in a function's register-name table (see FuncDef.RegisterNames):
+	// register Reg has the variable name Name from instruction StartPC up to,
+	// but not including, EndPC.
+	public class RegisterName {
+		public Byte Reg;
+		public Int32 StartPC;
+		public Int32 EndPC;
+		public Value Name;
+
+		public RegisterName(Byte reg, Int32 startPC, Int32 endPC, Value name) {
+			Reg = reg;
+			StartPC = startPC;
+			EndPC = endPC;
+			Name = name;
+		}
+	}
+
+	// A run of registers in a function's must-clear list (see FuncDef.MustClear):
+	// registers Start up to, but not including, End.
+	public class RegisterRun {
+		public Byte Start;
+		public Int32 End;
+
+		public RegisterRun(Byte start, Int32 end) {
+			Start = start;
+			End = end;
+		}
+	}
+
 	// Function definition: code, constants, and how many registers it needs
 	public class FuncDef {
 		public String Name = "";
@@ -15,6 +44,27 @@ namespace MiniScript {
 		public List<Value> ParamNames = new List<Value>();     // parameter names (as Value strings)
 		public List<Value> ParamDefaults = new List<Value>();  // default values for parameters
 
+		// Register names, as worked out ahead of time by the assembler (see
+		// Assembler.FindRegisterNames).  When NamesAreStatic, the VM doesn't
+		// keep names[] for this function as it runs, but fills it in from
+		// RegisterNames only if something needs a VarMap of its locals; and
+		// NamedLoads says, for each LOADV or LOADC, whether its register has
+		// the name it asks for there.  (The names are all from Constants or
+		// ParamNames.)
+		public Boolean NamesAreStatic = false;
+		public List<RegisterName> RegisterNames = new List<RegisterName>();
+		public List<Boolean> NamedLoads = new List<Boolean>();	// (by PC)
+
+		// The registers a call must clear (set to null) before this function
+		// runs: those it may read before writing, other than its parameters,
+		// as worked out by the assembler (see Assembler.FindMustClear).  If
+		// not MustClearIsKnown, a call clears all but the parameters.
+		public Boolean MustClearIsKnown = false;
+		public List<RegisterRun> MustClear = new List<RegisterRun>();
+
+		// PCs at which the VM should stop before executing (see VM.SetBreakpoint)
+		public List<Int32> Breakpoints = new List<Int32>();
+
 		public void ReserveRegister(Int32 registerNumber) {
 			UInt16 impliedCount = (UInt16)(registerNumber + 1);
 			if (MaxRegs < impliedCount) MaxRegs = impliedCount;
@@ -6,6 +6,7 @@ using System.Collections.Generic;
 // CPP: #include "value_string.h"
 // CPP: #include "value_list.h"
 // CPP: #include "value_map.h"
+// CPP: #include "value_range.h"
 // CPP: #include <sstream>
 // CPP: #include <cctype>
 
@@ -172,6 +173,15 @@ namespace MiniScript {
 				oss << "]";
 				return String(oss.str().c_str(), pool);
 			}
+			if (is_range(v)) {
+				std::ostringstream oss;
+				oss << "[";
+				for (int i = 0; i < range_count(v); i++) {
+					oss << (i != 0 ? ", " : "") << makeString(pool, range_get(v, i)).c_str();
+				}
+				oss << "]";
+				return String(oss.str().c_str(), pool);
+			}
 			if (is_map(v)) {
 				std::ostringstream oss;
 				oss << "{";
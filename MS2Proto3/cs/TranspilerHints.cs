@@ -0,0 +1,29 @@
+//*** BEGIN CS_ONLY ***
+// (This entire file is only for C#; the transpiler reads these attributes
+// itself, and the C++ code has no need of the classes.)
+
+using System;
+
+namespace MiniScript {
+
+	// [Specialize("flag")] on a method with a Boolean parameter named flag:
+	// in C++, make that parameter a template argument instead, so the method
+	// is compiled twice, and each copy has `if (flag)` resolved at compile
+	// time.  Callers must then pick a copy (e.g. via a `// CPP:` line).
+	[AttributeUsage(AttributeTargets.Method)]
+	public class SpecializeAttribute : Attribute {
+		public String Parameter;
+		public SpecializeAttribute(String parameter) {
+			Parameter = parameter;
+		}
+	}
+
+	// [Cold] on a method that is rarely called, such as one reporting an
+	// error: in C++, it's kept out of line, and any path that calls it is
+	// assumed unlikely (and moved out of the way of the hot code).
+	[AttributeUsage(AttributeTargets.Method)]
+	public class ColdAttribute : Attribute {
+	}
+
+}
+//*** END CS_ONLY ***
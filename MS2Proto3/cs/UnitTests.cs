@@ -8,6 +8,8 @@ using static MiniScript.ValueHelpers;
 // CPP: #include "StringUtils.g.h"
 // CPP: #include "Disassembler.g.h"
 // CPP: #include "Assembler.g.h"  // We really should automate this.
+// CPP: #include "Verifier.g.h"
+// CPP: #include "VM.g.h"
 
 namespace MiniScript {
 
@@ -223,6 +225,126 @@ namespace MiniScript {
 			return asmOk;
 		}
 
+		public static Boolean TestVerifier() {
+			// Assembled code passes...
+			List<String> source = new List<String> {
+				"LOAD r1, 5",
+				"loop:",
+				"BRLT r1, r0, loop",
+				"RETURN"
+			};
+			Assembler assem = new Assembler();
+			assem.Assemble(source);
+			List<FuncDef> funcs = assem.Functions;
+			Boolean ok = AssertEqual(Verifier.Verify(funcs), "");
+
+			// ...but not with a bad register, constant, branch, or ARG
+			List<UInt32> code = funcs[0].Code;
+			code[0] = BytecodeUtil.INS_AB(Opcode.LOAD_rA_iBC, 9, 5);
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: register r9 is outside the frame (at 0000)");
+			code[0] = BytecodeUtil.INS_AB(Opcode.LOAD_rA_kBC, 1, 0);
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: invalid constant index 0 (at 0000)");
+			code[0] = BytecodeUtil.INS(Opcode.JUMP_iABC) | 5;
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: branch target out of range (at 0000)");
+			code[0] = BytecodeUtil.INS(Opcode.ARG_iABC);
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: ARG without ARGBLK (at 0000)");
+			code[0] = BytecodeUtil.INS_AB(Opcode.TAILCALLF_iA_iBC, 1, 0);
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: TAILCALLF in @main (at 0000)");
+
+			// ...or if it can run off the end
+			code[0] = BytecodeUtil.INS(Opcode.NOOP);
+			code[2] = BytecodeUtil.INS(Opcode.NOOP);
+			ok = ok && AssertEqual(Verifier.Verify(funcs), "@main: execution can run off the end of the code (at 0002)");
+			return ok;
+		}
+
+		public static Boolean TestRegisterNames() {
+			// x is a parameter, so LOADV finds it; y is named on only one
+			// path, but that's fine as long as nothing looks at r2
+			List<String> source = new List<String> {
+				"@f:",
+				".param x",
+				"LOADV r2, r1, \"x\"",
+				"BRFALSE r1, skip",
+				"NAME r2, \"y\"",
+				"skip:",
+				"LOADV r0, r1, \"y\"",
+				"RETURN",
+				"@main:",
+				"RETURN"
+			};
+			Assembler assem = new Assembler();
+			assem.Assemble(source);
+			FuncDef f = assem.FindFunction("@f");
+			Boolean ok = Assert(f.NamesAreStatic, "@f should have static names")
+				&& Assert(f.NamedLoads[0], "LOADV of x should find it")
+				&& Assert(!f.NamedLoads[3], "LOADV of y from r1 should not")
+				&& AssertEqual(f.RegisterNames.Count, 1)
+				&& AssertEqual(f.RegisterNames[0].Reg, 1)
+				&& AssertEqual(f.RegisterNames[0].EndPC, 5);
+
+			// But a LOCALS there would look at r2, so then the VM must keep names
+			source.Insert(7, "LOCALS r3");
+			assem.Assemble(source);
+			ok = ok && Assert(!assem.FindFunction("@f").NamesAreStatic, "@f should not have static names");
+			ok = ok && Assert(!assem.FindFunction("@main").NamesAreStatic, "@main should never have static names");
+			return ok;
+		}
+
+		public static Boolean TestMustClear() {
+			// r2 is written before it's read, but r3 only on one path, and
+			// r4 never; so a call must clear r3 and r4 (and only those)
+			List<String> source = new List<String> {
+				"@f:",
+				".param x",
+				"LOAD r2, r1",
+				"BRFALSE r1, skip",
+				"LOAD r3, 1",
+				"skip:",
+				"ADD r0, r2, r3",
+				"ADD r0, r0, r4",
+				"RETURN",
+				"@main:",
+				"RETURN"
+			};
+			Assembler assem = new Assembler();
+			assem.Assemble(source);
+			FuncDef f = assem.FindFunction("@f");
+			return Assert(f.MustClearIsKnown, "@f should know what to clear")
+				&& AssertEqual(f.MustClear.Count, 1)
+				&& AssertEqual(f.MustClear[0].Start, 3)
+				&& AssertEqual(f.MustClear[0].End, 5);
+		}
+
+		public static Boolean TestBreakpoints() {
+			// A breakpoint on the loop body stops Run there on each pass (with
+			// r1 = 0, 1, 2); resuming runs on until the next pass, or the end
+			List<String> source = new List<String> {
+				"@main:",
+				"LOAD r1, 0",
+				"LOAD r2, 3",
+				"LOAD r3, 1",
+				"loop:",
+				"ADD r1, r1, r3",
+				"BRLT r1, r2, loop",
+				"RETURN"
+			};
+			Assembler assem = new Assembler();
+			assem.Assemble(source);
+			VM vm = new VM();
+			vm.Reset(assem.Functions);
+			vm.SetBreakpoint(vm.CurrentFunctionIndex(), 3);
+			Boolean ok = true;
+			for (Int32 pass = 0; ok && pass < 3; pass++) {
+				vm.Run();
+				ok = Assert(vm.AtBreakpoint, "Run should stop at the breakpoint")
+					&& AssertEqual(vm.PC, 3)
+					&& AssertEqual(as_int(vm.GetStackValue(1)), pass);
+			}
+			vm.Run();
+			return ok && Assert(!vm.AtBreakpoint && !vm.IsRunning, "Run should finish after the last pass");
+		}
+
 		public static Boolean TestValueMap() {
 			// Test map creation
 			Value map = make_empty_map();
@@ -301,6 +423,10 @@ namespace MiniScript {
 			return TestStringUtils()
 				&& TestDisassembler()
 				&& TestAssembler()
+				&& TestVerifier()
+				&& TestRegisterNames()
+				&& TestMustClear()
+				&& TestBreakpoints()
 				&& TestValueMap();
 		}
 	}
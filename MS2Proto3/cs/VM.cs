@@ -5,10 +5,14 @@ using System.Runtime.InteropServices;
 // CPP: #include "value.h"
 // CPP: #include "value_list.h"
 // CPP: #include "value_string.h"
+// CPP: #include "value_range.h"
+// CPP: #include "gc.h"
+// CPP: #include "gc_profile.h"
 // CPP: #include "Bytecode.g.h"
 // CPP: #include "FuncDef.g.h"
 // CPP: #include "IOHelper.g.h"
 // CPP: #include "Disassembler.g.h"
+// CPP: #include "Verifier.g.h"
 // CPP: #include "StringUtils.g.h"
 // CPP: #include "dispatch_macros.h"
 
@@ -18,33 +22,61 @@ namespace MiniScript {
 
 	using CallInfoRef = CallInfo;
 	using FuncDefRef = FuncDef;
+	using FuncDefPtr = FuncDef;
 	
-	// Call stack frame (return info)
+	// Call stack frame (return info).  The VM allocates all of these up front,
+	// and a call fills in the one at the top in place (see SetReturn).  Frame
+	// i also holds the locals VarMap, if any, of the function running at call
+	// depth i; that's made only when needed (by LOCALS or FUNCREF).  So is
+	// that function's part of names[], if its names are static (see LiveNames).
 	public class CallInfo {
 		public Int32 ReturnPC;        // where to continue in caller (PC index)
 		public Int32 ReturnBase;      // caller's base pointer (stack index)
-		public Int32 ReturnFuncIndex; // caller's function index in functions list
-		public Int32 CopyResultToReg; // register number to copy result to, or -1
+		public Int16 ReturnFuncIndex; // caller's function index in functions list
+		public Int16 CopyResultToReg; // register number to copy result to, or -1
+		public FuncDefPtr ReturnFunc; // caller's function (in the VM's functions list)
+		public List<UInt32> ReturnCode; // CPP: public: UInt32* ReturnCode;		// caller's code and constants, as Run caches them
+		public List<Value> ReturnConstants; // CPP: public: Value* ReturnConstants;
 		public Value LocalVarMap;     // VarMap representing locals, if any
 		public Value OuterVarMap;     // VarMap representing outer variables (closure context)
+		public Boolean LiveNames;     // whether names[] is kept for the function at this depth (false if none)
 
 		public CallInfo(Int32 returnPC, Int32 returnBase, Int32 returnFuncIndex, Int32 copyToReg=-1) {
+			SetReturn(returnPC, returnBase, returnFuncIndex, null, null, null, copyToReg, make_null());
+			LiveNames = false;
+		}
+
+		// Fill in the return info for a call.  This also drops the caller's
+		// locals VarMap, if any (so LOCALS after the call makes a new one,
+		// which sees any names added since).
+		//*** BEGIN CS_ONLY ***
+		public void SetReturn(Int32 returnPC, Int32 returnBase, Int32 returnFuncIndex, FuncDef returnFunc,
+		  List<UInt32> returnCode, List<Value> returnConstants, Int32 copyToReg, Value outerVars) {
 			ReturnPC = returnPC;
 			ReturnBase = returnBase;
-			ReturnFuncIndex = returnFuncIndex;
-			CopyResultToReg = copyToReg;
+			ReturnFuncIndex = (Int16)returnFuncIndex;
+			CopyResultToReg = (Int16)copyToReg;
+			ReturnFunc = returnFunc;
+			ReturnCode = returnCode;
+			ReturnConstants = returnConstants;
 			LocalVarMap = make_null();
-			OuterVarMap = val_null;
+			OuterVarMap = outerVars;
 		}
-
-		public CallInfo(Int32 returnPC, Int32 returnBase, Int32 returnFuncIndex, Int32 copyToReg, Value outerVars) {
+		//*** END CS_ONLY ***
+		/*** BEGIN H_ONLY ***
+		inline void SetReturn(Int32 returnPC, Int32 returnBase, Int32 returnFuncIndex, FuncDef* returnFunc,
+		  UInt32* returnCode, Value* returnConstants, Int32 copyToReg, Value outerVars) {
 			ReturnPC = returnPC;
 			ReturnBase = returnBase;
-			ReturnFuncIndex = returnFuncIndex;
-			CopyResultToReg = copyToReg;
+			ReturnFuncIndex = (Int16)returnFuncIndex;
+			CopyResultToReg = (Int16)copyToReg;
+			ReturnFunc = returnFunc;
+			ReturnCode = returnCode;
+			ReturnConstants = returnConstants;
 			LocalVarMap = make_null();
 			OuterVarMap = outerVars;
 		}
+		*** END H_ONLY ***/
 
 		//*** BEGIN CS_ONLY ***
 		public Value GetLocalVarMap(List<Value> registers, List<Value> names, int baseIdx, int regCount) {
@@ -79,13 +111,190 @@ namespace MiniScript {
 	// VM state
 	public class VM {
 		public Boolean DebugMode = false;
+		public Boolean ProfileOpcodes { get; private set; }	// see EnableOpcodeProfile
 		private List<Value> stack;
 		private List<Value> names;		// Variable names parallel to stack (null if unnamed)
 
 		private List<CallInfo> callStack;
 		private Int32 callStackTop;	   // Index of next free call stack slot
 
-		private List<FuncDef> functions; // functions addressed by CALLF
+		private List<FuncDef> functions; // functions addressed by CALLF (and pointed to by call frames, so changed only by Reset)
+
+		// Opcode sequence profile: how often each pair and triple of opcodes
+		// ran one after another (in straight-line code within one function)
+		private List<Int64> opPairCounts;		// [op1 * OP__COUNT + op2]
+		private List<Int64> opTripleCounts;		// [(op1 * OP__COUNT + op2) * OP__COUNT + op3]
+		private Int64 opProfileTotal = 0;		// instructions executed
+		private Int32 opProfilePrev1 = -1;		// previous opcode in this run, or -1
+		private Int32 opProfilePrev2 = -1;		// opcode before that, or -1
+		private Int32 opProfileNextPC = -1;		// PC that would continue this run
+		private Int32 opProfileFunc = -1;		// function index of this run
+
+		/*** BEGIN H_ONLY ***
+		// GC roots (C++ only): the registers and names in use, the call frames,
+		// and each function's constants, parameter names and defaults are all
+		// registered with the GC as root ranges, so it can collect mid-script.
+		private: Int32 stackTop = 0;	// Index just past the registers in use
+		private: Int32 stackHighWater = 0;	// Highest stackTop since the last GC
+		private: List<Int32> gcRootRanges;
+		private: Int32 gcScanHook = -1;	// Handle of our root scan hook, if added
+		private: static void ClearStaleRegisters(void* vm);
+		private: static int StackLiveCount(void* vm);
+		private: static int CallStackLiveCount(void* vm);
+		private: void AddGCRootList(List<Value>& values);
+		private: void AddGCRoots();
+		private: void RemoveGCRoots();
+		// Heap profiler hooks (see gc_profile.h); the VM also keeps
+		// gc_alloc_site up to date as it runs.
+		private: static int ProfileStack(void* vm, GCAllocSite* callers, int max);
+		private: static const char* ProfileFunctionName(void* vm, int function);
+		// Direct-threaded code (see dispatch_macros.h): the handler address of
+		// every instruction of every function, built when Run first needs it.
+		// Quickening rewrites an entry along with its instruction.  (Each
+		// RunLoop has its own labels, so this is rebuilt on changing loops.)
+		private: List<void*> threadedCode;
+		private: List<void**> threadedFuncs;	// start of each function's entries
+		private: void* const* threadedLabels = nullptr;	// labels it was built with
+		private: void BuildThreadedCode(void* const* labels);
+		// Tail-call dispatch (see dispatch_macros.h): one method per opcode,
+		// which the transpiler generates from that opcode's case in Run.
+#if VM_USE_TAIL_CALLS
+		private: typedef Value (VM::*TailHandler)(VM_TAIL_PARAMS);
+		private: static const TailHandler tailHandlers[(int)Opcode::OP__COUNT];
+		private: Value* tailStack;			// &stack[0]
+		private: FuncDef* tailFunc;			// the current function
+		private: Boolean tailHooks;		// whether to step, trace, or profile each instruction
+		private: Boolean tailSkipBreakpoint;	// (see skipBreakpoint in RunLoop)
+		private: __attribute__((noinline)) Value TailDispatch(VM_TAIL_PARAMS);
+		VM_OPCODES(VM_TAIL_DECLARE)
+#endif
+		public: ~VM() { RemoveGCRoots(); gc_profile_set_hooks(nullptr, nullptr, nullptr); }
+		*** END H_ONLY ***/
+		/*** BEGIN CPP_ONLY ***
+		void VM::BuildThreadedCode(void* const* labels) {
+			threadedCode.Clear();
+			threadedFuncs.Clear();
+			threadedLabels = labels;
+			List<Int32> starts;
+			for (Int32 f = 0; f < functions.Count(); f++) {
+				starts.Add(threadedCode.Count());
+				List<UInt32>& code = functions[f].Code;
+				for (Int32 i = 0; i < code.Count(); i++) {
+					threadedCode.Add(labels[BytecodeUtil::OP(code[i])]);
+				}
+				threadedCode.Add(nullptr);	// (so an empty function has a valid start)
+			}
+			// (only now that threadedCode is done growing can we take pointers into it)
+			for (Int32 f = 0; f < functions.Count(); f++) threadedFuncs.Add(&threadedCode[starts[f]]);
+		}
+
+#if VM_USE_TAIL_CALLS
+		const VM::TailHandler VM::tailHandlers[(int)Opcode::OP__COUNT] = { VM_OPCODES(VM_TAIL_LIST) };
+
+		Value VM::TailDispatch(VM_TAIL_PARAMS) {
+			// The top of Run's loop, in full; handlers come here only when
+			// something other than the next instruction needs doing
+			if (!IsRunning) {
+				PC = pc;
+				CurrentFunction = functions[_currentFuncIndex];
+				return make_null();
+			}
+			UInt32 instruction = curCode[pc++];
+			gc_alloc_site.pc = pc - 1;
+			if (tailHooks && !callStack[callStackTop].LiveNames) StartLiveNames(tailFunc, BaseIndex, pc - 1);
+			if (tailHooks && tailFunc->Breakpoints.Count() > 0 && !tailSkipBreakpoint && tailFunc->Breakpoints.Contains(pc - 1)) {
+				AtBreakpoint = true;
+				stoppedHere = true;
+				return Suspend(pc - 1, BaseIndex, _currentFuncIndex);
+			}
+			tailSkipBreakpoint = false;
+			if (stepping) {
+				if (stepsLeft == 0) {
+					stoppedHere = true;
+					return Suspend(pc - 1, BaseIndex, _currentFuncIndex);
+				}
+				stepsLeft--;
+			}
+			if (DebugMode) {
+				IOHelper::Print(StringUtils::Format("{0} {1}: {2}     r0:{3}, r1:{4}, r2:{5}",
+					tailFunc->Name,
+					StringUtils::ZeroPad(pc-1, 4),
+					Disassembler::ToString(instruction),
+					localStack[0], localStack[1], localStack[2]));
+			}
+			Opcode opcode = (Opcode)BytecodeUtil::OP(instruction);
+			if (ProfileOpcodes) CountOpcode(opcode, pc - 1, _currentFuncIndex);
+			VM_MUSTTAIL return (this->*tailHandlers[(int)opcode])(VM_TAIL_ARGS);
+		}
+#endif
+
+		void VM::ClearStaleRegisters(void* vm) {
+			// Registers above the top are left as they were by calls that have
+			// returned, and a call only clears those its callee might read
+			// (see FuncDef.MustClear).  The GC won't mark them, so (as a root
+			// scan hook) null them before each scan, lest a later frame take
+			// them in still pointing at what this collection frees.
+			VM* self = (VM*)vm;
+			int count = StackLiveCount(vm);
+			int stale = self->stackHighWater < self->stack.Count() ? self->stackHighWater : self->stack.Count();
+			for (int i = count; i < stale; i++) self->stack[i] = make_null();
+			self->stackHighWater = count;
+		}
+
+		int VM::StackLiveCount(void* vm) {
+			VM* self = (VM*)vm;
+			return self->stackTop < self->stack.Count() ? self->stackTop : self->stack.Count();
+		}
+
+		int VM::CallStackLiveCount(void* vm) {
+			// The frame at callStackTop is in use too (it holds the current LocalVarMap)
+			VM* self = (VM*)vm;
+			return self->callStackTop < self->callStack.Count() ? self->callStackTop + 1 : self->callStackTop;
+		}
+
+		void VM::AddGCRootList(List<Value>& values) {
+			if (values.Count() == 0) return;
+			gcRootRanges.Add(gc_add_root_range(&values[0], values.Count(), sizeof(Value), nullptr, nullptr));
+		}
+
+		void VM::AddGCRoots() {
+			RemoveGCRoots();
+			gcScanHook = gc_add_root_scan_hook(ClearStaleRegisters, this);
+			gcRootRanges.Add(gc_add_root_range(&stack[0], 0, sizeof(Value), StackLiveCount, this));
+			gcRootRanges.Add(gc_add_root_range(&names[0], 0, sizeof(Value), StackLiveCount, this));
+			gcRootRanges.Add(gc_add_root_range(&callStack[0].LocalVarMap, 0, sizeof(CallInfo), CallStackLiveCount, this));
+			gcRootRanges.Add(gc_add_root_range(&callStack[0].OuterVarMap, 0, sizeof(CallInfo), CallStackLiveCount, this));
+			for (Int32 i = 0; i < functions.Count(); i++) {
+				AddGCRootList(functions[i].Constants);
+				AddGCRootList(functions[i].ParamNames);
+				AddGCRootList(functions[i].ParamDefaults);
+			}
+		}
+
+		void VM::RemoveGCRoots() {
+			for (Int32 i = 0; i < gcRootRanges.Count(); i++) gc_remove_root_range(gcRootRanges[i]);
+			gcRootRanges.Clear();
+			if (gcScanHook >= 0) gc_remove_root_scan_hook(gcScanHook);
+			gcScanHook = -1;
+		}
+
+		int VM::ProfileStack(void* vm, GCAllocSite* callers, int max) {
+			// Each frame's return PC is just past its call instruction
+			VM* self = (VM*)vm;
+			int count = 0;
+			for (Int32 i = self->callStackTop - 1; i >= 0 && count < max; i--, count++) {
+				callers[count].function = self->callStack[i].ReturnFuncIndex;
+				callers[count].pc = self->callStack[i].ReturnPC - 1;
+			}
+			return count;
+		}
+
+		const char* VM::ProfileFunctionName(void* vm, int function) {
+			VM* self = (VM*)vm;
+			if (function < 0 || function >= self->functions.Count()) return nullptr;
+			return self->functions[function].Name.c_str();
+		}
+		*** END CPP_ONLY ***/
 
 		// Execution state (persistent across RunSteps calls)
 		public Int32 PC { get; private set; }
@@ -95,6 +304,17 @@ namespace MiniScript {
 		public Int32 BaseIndex { get; private set; }
 		public String RuntimeError { get; private set; }
 
+		// Single-stepping (see Step): Run then counts down stepsLeft before
+		// every instruction, rather than its cycle budget at safepoints.
+		private Boolean stepping = false;
+		private UInt32 stepsLeft = 0;
+
+		// Breakpoints (see SetBreakpoint): Run stops before an instruction
+		// whose PC is in its function's Breakpoints, and sets AtBreakpoint.
+		public Boolean AtBreakpoint { get; private set; }
+		private Int32 breakpointCount = 0;	// (total, over all functions)
+		private Boolean stoppedHere = false;	// Run last stopped at PC for a breakpoint or Step
+
 		public Int32 StackSize() {
 			return stack.Count;
 		}
@@ -117,11 +337,88 @@ namespace MiniScript {
 			return callStack[index];
 		}
 
+		public Int32 CurrentFunctionIndex() {
+			return _currentFuncIndex;
+		}
+
 		public String GetFunctionName(Int32 funcIndex) {
 			if (funcIndex < 0 || funcIndex >= functions.Count) return "???";
 			return functions[funcIndex].Name;
 		}
 
+		// Start counting how often each pair and triple of opcodes executes in
+		// sequence (to find candidates for superinstructions; see
+		// Assembler.FuseSuperinstructions).  This slows the VM down a bit.
+		public void EnableOpcodeProfile() {
+			Int32 n = (Int32)Opcode.OP__COUNT;
+			opPairCounts = new List<Int64>();
+			for (Int32 i = 0; i < n * n; i++) opPairCounts.Add(0);
+			opTripleCounts = new List<Int64>();
+			for (Int32 i = 0; i < n * n * n; i++) opTripleCounts.Add(0);
+			opProfileTotal = 0;
+			opProfilePrev1 = -1;
+			opProfilePrev2 = -1;
+			ProfileOpcodes = true;
+		}
+
+		private void CountOpcode(Opcode opcode, Int32 pcIndex, Int32 funcIndex) {
+			Int32 n = (Int32)Opcode.OP__COUNT;
+			Int32 op = (Int32)opcode;
+			if (pcIndex != opProfileNextPC || funcIndex != opProfileFunc) {
+				// We jumped, called, or returned: start a new run
+				opProfilePrev1 = -1;
+				opProfilePrev2 = -1;
+			}
+			if (opProfilePrev1 >= 0) {
+				opPairCounts[opProfilePrev1 * n + op]++;
+				if (opProfilePrev2 >= 0) opTripleCounts[(opProfilePrev2 * n + opProfilePrev1) * n + op]++;
+			}
+			opProfileTotal++;
+			opProfilePrev2 = opProfilePrev1;
+			opProfilePrev1 = op;
+			opProfileNextPC = pcIndex + 1;
+			opProfileFunc = funcIndex;
+		}
+
+		// Return a report of the most frequent opcode pairs and triples.
+		public List<String> OpcodeProfileReport(Int32 topCount) {
+			List<String> result = new List<String>();
+			result.Add(StringUtils.Format("Instructions executed: {0}", opProfileTotal));
+			result.Add("Most frequent opcode pairs:");
+			AddTopSequences(opPairCounts, 2, topCount, result);
+			result.Add("Most frequent opcode triples:");
+			AddTopSequences(opTripleCounts, 3, topCount, result);
+			return result;
+		}
+
+		private void AddTopSequences(List<Int64> counts, Int32 length, Int32 topCount, List<String> result) {
+			// Find the indexes of the topCount biggest counts, biggest first
+			List<Int32> top = new List<Int32>();
+			for (Int32 i = 0; i < counts.Count; i++) {
+				if (counts[i] == 0) continue;
+				if (top.Count == topCount && counts[i] <= counts[top[top.Count - 1]]) continue;
+				Int32 pos = top.Count;
+				while (pos > 0 && counts[top[pos - 1]] < counts[i]) pos--;
+				top.Insert(pos, i);
+				if (top.Count > topCount) top.RemoveAt(topCount);
+			}
+
+			Int32 n = (Int32)Opcode.OP__COUNT;
+			for (Int32 i = 0; i < top.Count; i++) {
+				Int64 count = counts[top[i]];
+				Int64 tenths = opProfileTotal > 0 ? count * 1000 / opProfileTotal : 0;
+				String ops = "";
+				Int32 index = top[i];
+				for (Int32 j = 0; j < length; j++) {
+					String name = BytecodeUtil.ToMnemonic((Opcode)(index % n));
+					ops = (j == 0) ? name : name + " > " + ops;
+					index = index / n;
+				}
+				result.Add(StringUtils.Format("  {0}.{1}%  {2}  {3}", tenths / 10, tenths % 10,
+					StringUtils.SpacePad(StringUtils.Format("{0}", count), 12), ops));
+			}
+		}
+
 		public VM() {
 			InitVM(1024, 256);
 		}
@@ -137,6 +434,7 @@ namespace MiniScript {
 			functions = new List<FuncDef>();
 			callStackTop = 0;
 			RuntimeError = "";
+			ProfileOpcodes = false;
 
 			// Initialize stack with null values
 			for (Int32 i = 0; i < stackSlots; i++) {
@@ -169,12 +467,24 @@ namespace MiniScript {
 				return;
 			}
 
-			// Basic validation - simplified for C++ transpilation
-			if (mainFunc.Code.Count == 0) {
-				IOHelper.Print("Entry function has no code");
+			// Verify all the code up front, so that Run needn't check for bad
+			// registers, constants, functions, branches, or ARGBLKs as it goes
+			IsRunning = false;
+			String verifyError = Verifier.Verify(functions);
+			if (verifyError != "") {
+				IOHelper.Print(StringUtils.Format("Bytecode verification failed in {0}", verifyError));
 				return;
 			}
 
+			// Make the register stack deep enough for as many nested calls as
+			// the call stack allows (plus the call that would overflow it), so
+			// that calls needn't check it either
+			Int32 stackNeeded = (callStack.Count + 1) * Verifier.MaxCallWindow(functions) + 256;
+			while (stack.Count < stackNeeded) {
+				stack.Add(make_null());
+				names.Add(make_null());
+			}
+
 			// Find the entry function index
 			_currentFuncIndex = -1;
 			for (Int32 i = 0; i < functions.Count; i++) {
@@ -189,8 +499,19 @@ namespace MiniScript {
 			PC = 0;				 // start at entry code
 			CurrentFunction = mainFunc;
 			IsRunning = true;
+			for (Int32 i = 0; i <= callStackTop && i < callStack.Count; i++) {
+				callStack[i].LocalVarMap = make_null();	// (left by a run that stopped early)
+				callStack[i].LiveNames = false;
+			}
 			callStackTop = 0;
+			callStack[0].LiveNames = !mainFunc.NamesAreStatic;
 			RuntimeError = "";
+			ClearBreakpoints();
+			AtBreakpoint = false;
+			stoppedHere = false;
+			// CPP: AddGCRoots();
+			// CPP: threadedFuncs.Clear();	// (rebuilt for the new functions on the next Run)
+			// CPP: gc_profile_set_hooks(ProfileStack, ProfileFunctionName, this);
 
 			EnsureFrame(BaseIndex, CurrentFunction.MaxRegs);
 
@@ -199,11 +520,18 @@ namespace MiniScript {
 			}
 		}
 
+		[Cold]
 		public void RaiseRuntimeError(String message) {
 			RuntimeError = message;
 			IsRunning = false;
 		}
 		
+		// Print a fault that isn't a runtime error (such as call stack overflow).
+		[Cold]
+		private void PrintFault(String message) {
+			IOHelper.Print(message);
+		}
+
 		public bool ReportRuntimeError() {
 			if (String.IsNullOrEmpty(RuntimeError)) return false;
 			IOHelper.Print(StringUtils.Format("Runtime error: {0} [{1} line {2}]",
@@ -214,7 +542,7 @@ namespace MiniScript {
 		// Helper for argument processing (FUNCTION_CALLS.md steps 1-3):
 		// Process ARG instructions, validate argument count, and set up parameter registers.
 		// Returns the PC after the CALL instruction, or -1 on error.
-		private Int32 ProcessArguments(Int32 argCount, Int32 startPC, Int32 callerBase, Int32 calleeBase, FuncDef callee, ref List<UInt32> code) {
+		private Int32 ProcessArguments(Int32 argCount, Int32 startPC, Int32 callerBase, Int32 calleeBase, FuncDefPtr callee, ref List<UInt32> code) {
 			Int32 paramCount = callee.ParamNames.Count;
 
 			// Step 1: Validate argument count
@@ -231,24 +559,20 @@ namespace MiniScript {
 				UInt32 argInstruction = code[currentPC];
 				Opcode argOp = (Opcode)BytecodeUtil.OP(argInstruction);
 
-				Value argValue = make_null();
+				Value argValue;
 				if (argOp == Opcode.ARG_rA) {
 					// Argument from register
 					Byte srcReg = BytecodeUtil.Au(argInstruction);
 					argValue = stack[callerBase + srcReg];
-				} else if (argOp == Opcode.ARG_iABC) {
-					// Argument immediate value
+				} else {
+					// Argument immediate value (ARG_iABC, as the verifier ensures)
 					Int32 immediate = BytecodeUtil.ABCs(argInstruction);
 					argValue = make_int(immediate);
-				} else {
-					RaiseRuntimeError("Expected ARG opcode in ARGBLK");
-					return -1;
 				}
 
-				// Copy argument value to callee's parameter register and assign name
-				// Parameters start at r1, so offset by 1
+				// Copy argument value to callee's parameter register
+				// (SetupCallFrame names it).  Parameters start at r1, so offset by 1
 				stack[calleeBase + 1 + i] = argValue;
-				names[calleeBase + 1 + i] = callee.ParamNames[i];
 
 				currentPC++;
 			}
@@ -259,22 +583,24 @@ namespace MiniScript {
 		// Helper for call setup (FUNCTION_CALLS.md steps 4-6):
 		// Initialize remaining parameters with defaults and clear callee's registers.
 		// Note: Parameters start at r1 (r0 is reserved for return value)
-		private void SetupCallFrame(Int32 argCount, Int32 calleeBase, FuncDef callee) {
+		private void SetupCallFrame(Int32 argCount, Int32 calleeBase, FuncDefPtr callee) {
 			Int32 paramCount = callee.ParamNames.Count;
 
 			// Step 4: Set up remaining parameters with default values
 			// Parameters start at r1, so offset by 1
 			for (Int32 i = argCount; i < paramCount; i++) {
 				stack[calleeBase + 1 + i] = callee.ParamDefaults[i];
-				names[calleeBase + 1 + i] = callee.ParamNames[i];
 			}
 
-			// Step 5: Clear remaining registers (r0, and any beyond parameters)
-			stack[calleeBase] = make_null();
-			names[calleeBase] = make_null();
-			for (Int32 i = paramCount + 1; i < callee.MaxRegs; i++) {
-				stack[calleeBase + i] = make_null();
-				names[calleeBase + i] = make_null();
+			// Step 5: Clear the other registers the callee might read
+			ClearRegisters(callee, calleeBase);
+
+			// And name the parameters (and unname the rest), unless the callee's
+			// names are static, in which case names[] is left until it's needed
+			if (!callee.NamesAreStatic) {
+				names[calleeBase] = make_null();
+				for (Int32 i = 0; i < paramCount; i++) names[calleeBase + 1 + i] = callee.ParamNames[i];
+				for (Int32 i = paramCount + 1; i < callee.MaxRegs; i++) names[calleeBase + i] = make_null();
 			}
 
 			// Step 6 is handled by the caller (pushing CallInfo, switching frame, etc.)
@@ -292,29 +618,60 @@ namespace MiniScript {
 			return Run(maxCycles);
 		}
 
+		// Run until the program ends, or until about maxCycles instructions
+		// have run (0 = no limit), and then return (Run again to resume).
+		// The budget is only checked at safepoints: backward branches, which
+		// charge it for the whole loop body, and calls and returns.  So Run
+		// may go a bit past maxCycles; use Step to stop at an exact instruction.
 		public Value Run(UInt32 maxCycles=0) {
 			if (!IsRunning || !CurrentFunction) {
 				return make_null();
 			}
+			AtBreakpoint = false;
+			Boolean hooks = stepping || DebugMode || ProfileOpcodes || breakpointCount > 0;	// (per-instruction work)
+			return RunLoop(maxCycles, hooks); // CPP: return hooks ? RunLoop<true>(maxCycles) : RunLoop<false>(maxCycles);
+		}
 
+		// The body of Run.  In C++ there are two of these: RunLoop<false>, the
+		// usual case, has no stepping, tracing, profiling or breakpoint code in
+		// its loop at all; RunLoop<true> does all of that before every instruction.
+		[Specialize("hooks")]
+		private Value RunLoop(UInt32 maxCycles, Boolean hooks) {
 			// Copy instance variables to locals for performance
 			Int32 pc = PC;
 			Int32 baseIndex = BaseIndex;
 			Int32 currentFuncIndex = _currentFuncIndex;
 
-			FuncDefRef curFunc = CurrentFunction; // should be: FuncDef& curFunc = CurrentFunction;
-			Int32 codeCount = curFunc.Code.Count;
-			var curCode = curFunc.Code; // CPP: UInt32* curCode = &curFunc.Code[0];
-			var curConstants = curFunc.Constants; // CPP: Value* curConstants = &curFunc.Constants[0];
+			FuncDefPtr curFunc = functions[currentFuncIndex];
+			var curCode = curFunc.Code; // CPP: UInt32* curCode = &curFunc->Code[0];
+			var curConstants = curFunc.Constants; // CPP: Value* curConstants = &curFunc->Constants[0];
 
-			UInt32 cyclesLeft = maxCycles;
-			if (maxCycles == 0) cyclesLeft--;  // wraps to MAX_UINT32
+			Int64 cyclesLeft = maxCycles;
+			if (maxCycles == 0) cyclesLeft = Int64.MaxValue;
+			Boolean profileOps = ProfileOpcodes;
+			Boolean skipBreakpoint = stoppedHere;	// (so we don't stop again where we last stopped)
+			stoppedHere = false;
+			// CPP: gc_alloc_site.function = currentFuncIndex;
 
 /*** BEGIN CPP_ONLY ***
 			Value* stackPtr = &stack[0];
-#if VM_USE_COMPUTED_GOTO
+#if VM_USE_TAIL_CALLS
+			if (DebugMode) IOHelper::Print("(Running with tail-call dispatch)");
+			tailStack = stackPtr;
+			tailFunc = curFunc;
+			tailHooks = hooks;
+			tailSkipBreakpoint = skipBreakpoint;
+			return TailDispatch(pc, stackPtr + baseIndex, curConstants, curCode, cyclesLeft);
+#elif VM_USE_COMPUTED_GOTO
 			static void* const vm_labels[(int)Opcode::OP__COUNT] = { VM_OPCODES(VM_LABEL_LIST) };
+#if VM_USE_THREADED_CODE
+			if (threadedFuncs.Count() != functions.Count() || threadedLabels != vm_labels) BuildThreadedCode(vm_labels);
+			void** const* funcHandlers = &threadedFuncs[0];
+			void** curHandlers = funcHandlers[currentFuncIndex];
+			if (DebugMode) IOHelper::Print("(Running with direct-threaded dispatch)");
+#else
 			if (DebugMode) IOHelper::Print("(Running with computed-goto dispatch)");
+#endif
 #else
 			if (DebugMode) IOHelper::Print("(Running with switch-based dispatch)");
 #endif
@@ -322,40 +679,39 @@ namespace MiniScript {
 
 			while (IsRunning) {
 				// CPP: VM_DISPATCH_TOP();
-				if (cyclesLeft == 0) {
-					// Update instance variables before returning
-					PC = pc;
-					BaseIndex = baseIndex;
-					_currentFuncIndex = currentFuncIndex;
-					CurrentFunction = curFunc;
-					return make_null();
-				}
-				cyclesLeft--;
-
-				if (pc >= codeCount) {
-					IOHelper.Print("VM: PC out of bounds");
-					IsRunning = false;
-					// Update instance variables before returning
-					PC = pc;
-					BaseIndex = baseIndex;
-					_currentFuncIndex = currentFuncIndex;
-					CurrentFunction = curFunc;
-					return make_null();
-				}
-
-				UInt32 instruction = curCode[pc++];
+				// (No cycle or PC check here: the budget is checked at safepoints,
+				// and the assembler ends every function with RETURN or JUMP.)
+				UInt32 instruction = curCode[pc++]; // CPP: VM_FETCH();
+				// CPP: gc_alloc_site.pc = pc - 1;
 				Span<Value> localStack = CollectionsMarshal.AsSpan(stack).Slice(baseIndex); // CPP: Value* localStack = stackPtr + baseIndex;
+				Opcode opcode = (Opcode)BytecodeUtil.OP(instruction);
 
-				if (DebugMode) {
-					// Debug output disabled for C++ transpilation
-					IOHelper.Print(StringUtils.Format("{0} {1}: {2}     r0:{3}, r1:{4}, r2:{5}",
-						curFunc.Name,
-						StringUtils.ZeroPad(pc-1, 4),
-						Disassembler.ToString(instruction),
-						localStack[0], localStack[1], localStack[2]));
+				if (hooks) {
+					// (keep names for every function, so they can be inspected)
+					if (!callStack[callStackTop].LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
+					if (curFunc.Breakpoints.Count > 0 && !skipBreakpoint && curFunc.Breakpoints.Contains(pc - 1)) {
+						AtBreakpoint = true;
+						stoppedHere = true;
+						return Suspend(pc - 1, baseIndex, currentFuncIndex);
+					}
+					skipBreakpoint = false;
+					if (stepping) {
+						if (stepsLeft == 0) {
+							stoppedHere = true;
+							return Suspend(pc - 1, baseIndex, currentFuncIndex);
+						}
+						stepsLeft--;
+					}
+					if (DebugMode) {
+						// Debug output disabled for C++ transpilation
+						IOHelper.Print(StringUtils.Format("{0} {1}: {2}     r0:{3}, r1:{4}, r2:{5}",
+							curFunc.Name,
+							StringUtils.ZeroPad(pc-1, 4),
+							Disassembler.ToString(instruction),
+							localStack[0], localStack[1], localStack[2]));
+					}
+					if (profileOps) CountOpcode(opcode, pc - 1, currentFuncIndex);
 				}
-
-				Opcode opcode = (Opcode)BytecodeUtil.OP(instruction);
 				
 				switch (opcode) { // CPP: VM_DISPATCH_BEGIN();
 				
@@ -394,10 +750,13 @@ namespace MiniScript {
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
 
-						// Check if the source register has the expected name
+						// Check if the source register has the expected name (which
+						// the assembler has worked out, unless we're keeping names)
 						Value expectedName = curConstants[c];
-						Value actualName = names[baseIndex + b];
-						if (value_identical(expectedName, actualName)) {
+						Boolean named;
+						if (callStack[callStackTop].LiveNames) named = value_identical(expectedName, names[baseIndex + b]);
+						else named = curFunc.NamedLoads[pc - 1];
+						if (named) {
 							localStack[a] = localStack[b];
 						} else {
 							// Variable not found in current scope, look in outer context
@@ -415,9 +774,11 @@ namespace MiniScript {
 
 						// Check if the source register has the expected name
 						Value expectedName = curConstants[c];
-						Value actualName = names[baseIndex + b];
+						Boolean named;
+						if (callStack[callStackTop].LiveNames) named = value_identical(expectedName, names[baseIndex + b]);
+						else named = curFunc.NamedLoads[pc - 1];
 						Value val;
-						if (value_identical(expectedName, actualName)) {
+						if (named) {
 							val = localStack[b];
 						} else {
 							// Variable not found in current scope, look in outer context
@@ -430,37 +791,39 @@ namespace MiniScript {
 						} else {
 							// Harder case: value is a funcref, which we must invoke,
 							// and then copy the result into localStack[a] upon return.
+							// (A funcref's index is good: FUNCREF made it, and the
+							// verifier checked the FUNCREF.)
 							Int32 funcIndex = funcref_index(val);
-							if (funcIndex < 0 || funcIndex >= functions.Count) {
-								IOHelper.Print("LOADC to invalid func");
-								return make_null();
-							}
-
-							FuncDef callee = functions[funcIndex];
+							FuncDefPtr callee = functions[funcIndex];
 							Value outerVars = funcref_outer_vars(val);
 
 							// Push return info with closure context
 							if (callStackTop >= callStack.Count) {
-								IOHelper.Print("Call stack overflow");
+								PrintFault("Call stack overflow");
 								return make_null();
 							}
-							callStack[callStackTop] = new CallInfo(pc, baseIndex, currentFuncIndex, a, outerVars);
+							callStack[callStackTop].SetReturn(pc, baseIndex, currentFuncIndex, curFunc, curCode, curConstants, a, outerVars);
 							callStackTop++;
+							if (!callee.NamesAreStatic) callStack[callStackTop].LiveNames = true;
 
 							// Switch to callee frame: base slides to argument window
 							baseIndex += curFunc.MaxRegs;
-							for (Int32 i = 0; i < callee.MaxRegs; i++) { // clear registers (ugh)
-								stack[baseIndex + i] = make_null();
-								names[baseIndex + i] = make_null();
+							// (no arguments here, so its parameters are null too)
+							for (Int32 i = 1; i <= callee.ParamNames.Count; i++) stack[baseIndex + i] = make_null();
+							ClearRegisters(callee, baseIndex);
+							if (!callee.NamesAreStatic) {
+								for (Int32 i = 0; i < callee.MaxRegs; i++) names[baseIndex + i] = make_null();
 							}
 							pc = 0; // Start at beginning of callee code
 							curFunc = callee; // Switch to callee function
-							codeCount = curFunc.Code.Count;
-							curCode = curFunc.Code; // CPP: curCode = &curFunc.Code[0];
-							curConstants = curFunc.Constants; // CPP: curConstants = &curFunc.Constants[0];
+							curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+							curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
 							currentFuncIndex = funcIndex; // Switch to callee function index
+							// CPP: gc_alloc_site.function = currentFuncIndex;
+							// CPP: VM_SET_HANDLERS();
 
 							EnsureFrame(baseIndex, callee.MaxRegs);
+							if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						}
 						break;
 					}
@@ -471,6 +834,8 @@ namespace MiniScript {
 						Int16 funcIndex = BytecodeUtil.BCs(instruction);
 
 						// Create function reference with our locals as the closure context
+						// (whose names must now be kept up to date)
+						if (!callStack[callStackTop].LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
 						CallInfoRef frame = callStack[callStackTop];
 						Value locals = frame.GetLocalVarMap(stack, names, baseIndex, curFunc.MaxRegs);
 						localStack[a] = make_funcref(funcIndex, locals);
@@ -483,7 +848,7 @@ namespace MiniScript {
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
 						localStack[a] = localStack[b];
-						names[baseIndex + a] = curConstants[c];	// OFI: keep localNames?
+						if (callStack[callStackTop].LiveNames) names[baseIndex + a] = curConstants[c];
 						break;
 					}
 
@@ -491,7 +856,7 @@ namespace MiniScript {
 						// names[baseIndex + A] = constants[BC] (without changing R[A])
 						Byte a = BytecodeUtil.Au(instruction);
 						UInt16 constIdx = BytecodeUtil.BCu(instruction);
-						names[baseIndex + a] = curConstants[constIdx];	// OFI: keep localNames?
+						if (callStack[callStackTop].LiveNames) names[baseIndex + a] = curConstants[constIdx];
 						break;
 					}
 
@@ -500,6 +865,12 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
+						// Quicken if the operands are both ints or both doubles
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.ADD_INT_rA_rB_rC);  // CPP: VM_REWRITE(ADD_INT_rA_rB_rC);
+						} else if (is_double(localStack[b]) && is_double(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.ADD_DBL_rA_rB_rC);  // CPP: VM_REWRITE(ADD_DBL_rA_rB_rC);
+						}
 						localStack[a] = value_add(localStack[b], localStack[c]);
 						break;
 					}
@@ -509,6 +880,12 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
+						// Quicken if the operands are both ints or both doubles
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.SUB_INT_rA_rB_rC);  // CPP: VM_REWRITE(SUB_INT_rA_rB_rC);
+						} else if (is_double(localStack[b]) && is_double(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.SUB_DBL_rA_rB_rC);  // CPP: VM_REWRITE(SUB_DBL_rA_rB_rC);
+						}
 						localStack[a] = value_sub(localStack[b], localStack[c]);
 						break;
 					}
@@ -518,6 +895,12 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
+						// Quicken if the operands are both ints or both doubles
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.MULT_INT_rA_rB_rC);  // CPP: VM_REWRITE(MULT_INT_rA_rB_rC);
+						} else if (is_double(localStack[b]) && is_double(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.MULT_DBL_rA_rB_rC);  // CPP: VM_REWRITE(MULT_DBL_rA_rB_rC);
+						}
 						localStack[a] = value_mult(localStack[b], localStack[c]);
 						break;
 					}
@@ -560,6 +943,10 @@ namespace MiniScript {
 						// list_push(R[A], R[B])
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
+						if (is_range(localStack[a])) {
+							// (turn a range into a list before changing it; see IDXSET)
+							localStack[a] = range_to_list(localStack[a]);
+						}
 						list_push(localStack[a], localStack[b]);
 						break;
 					}
@@ -575,6 +962,8 @@ namespace MiniScript {
 						if (is_list(container)) {
 							// ToDo: add a list_try_get and use it here, like we do with map below
 							localStack[a] = list_get(container, as_int(index));
+						} else if (is_range(container)) {
+							localStack[a] = range_get(container, as_int(index));
 						} else if (is_map(container)) {
 							Value result;
 							if (!map_try_get(container, index, out result)) {
@@ -597,6 +986,12 @@ namespace MiniScript {
 						Value index = localStack[b];
 						Value value = localStack[c];
 
+						if (is_range(container)) {
+							// To change a range, we first turn it into a list (which
+							// the range itself then refers to, so aliases see the change)
+							container = range_to_list(container);
+							localStack[a] = container;
+						}
 						if (is_list(container)) {
 							list_set(container, as_int(index), value);
 						} else if (is_map(container)) {
@@ -609,7 +1004,9 @@ namespace MiniScript {
 
 					case Opcode.LOCALS_rA: {
 						// Create VarMap for local variables and store in R[A]
+						// (whose names must now be kept up to date)
 						Byte a = BytecodeUtil.Au(instruction);
+						if (!callStack[callStackTop].LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
 
 						CallInfoRef frame = callStack[callStackTop];
 						localStack[a] = frame.GetLocalVarMap(stack, names, baseIndex, curFunc.MaxRegs);
@@ -623,17 +1020,18 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						CallInfoRef frame = callStack[callStackTop-1];
 						localStack[a] = frame.OuterVarMap;
-						names[baseIndex+a] = make_null();
+						if (callStack[callStackTop].LiveNames) names[baseIndex+a] = make_null();
 						break;
 					}
 
 					case Opcode.GLOBALS_rA: {
 						// Create VarMap for global variables and store in R[A]
+						// (@main's names are always kept, so that's ready to go)
 						// TODO: Implement global variable map access
 						Byte a = BytecodeUtil.Au(instruction);
 						Int32 globalRegCount = functions[callStack[0].ReturnFuncIndex].MaxRegs;
 						localStack[a] = callStack[0].GetLocalVarMap(stack, names, 0, globalRegCount);
-						names[baseIndex+a] = make_null();
+						if (callStack[callStackTop].LiveNames) names[baseIndex+a] = make_null();
 						break;
 					}
 
@@ -641,6 +1039,8 @@ namespace MiniScript {
 						// Jump by signed 24-bit ABC offset from current PC
 						Int32 offset = BytecodeUtil.ABCs(instruction);
 						pc += offset;
+						// Safepoint: a backward jump charges the cycle budget for the loop body
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -650,6 +1050,9 @@ namespace MiniScript {
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
 
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.LT_INT_rA_rB_rC);  // CPP: VM_REWRITE(LT_INT_rA_rB_rC);  // quicken
+						}
 						localStack[a] = make_int(value_lt(localStack[b], localStack[c]));
 						break;
 					}
@@ -680,6 +1083,9 @@ namespace MiniScript {
 						Byte b = BytecodeUtil.Bu(instruction);
 						Byte c = BytecodeUtil.Cu(instruction);
 
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.LE_INT_rA_rB_rC);  // CPP: VM_REWRITE(LE_INT_rA_rB_rC);  // quicken
+						}
 						localStack[a] = make_int(value_le(localStack[b], localStack[c]));
 						break;
 					}
@@ -750,6 +1156,7 @@ namespace MiniScript {
 						if (is_truthy(localStack[a])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -759,6 +1166,7 @@ namespace MiniScript {
 						if (!is_truthy(localStack[a])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -767,9 +1175,13 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
 						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLT_INT_rA_rB_iC);  // CPP: VM_REWRITE(BRLT_INT_rA_rB_iC);  // quicken
+						}
 						if (value_lt(localStack[a], localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -778,9 +1190,13 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						SByte b = BytecodeUtil.Bs(instruction);
 						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLT_INT_rA_iB_iC);  // CPP: VM_REWRITE(BRLT_INT_rA_iB_iC);  // quicken
+						}
 						if (value_lt(localStack[a], make_int(b))){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -792,6 +1208,7 @@ namespace MiniScript {
 						if (value_lt(make_int(a), localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -800,9 +1217,13 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
 						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLE_INT_rA_rB_iC);  // CPP: VM_REWRITE(BRLE_INT_rA_rB_iC);  // quicken
+						}
 						if (value_le(localStack[a], localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -811,9 +1232,13 @@ namespace MiniScript {
 						Byte a = BytecodeUtil.Au(instruction);
 						SByte b = BytecodeUtil.Bs(instruction);
 						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLE_INT_rA_iB_iC);  // CPP: VM_REWRITE(BRLE_INT_rA_iB_iC);  // quicken
+						}
 						if (value_le(localStack[a], make_int(b))){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -825,6 +1250,7 @@ namespace MiniScript {
 						if (value_le(make_int(a), localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -836,6 +1262,7 @@ namespace MiniScript {
 						if (value_equal(localStack[a], localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -847,6 +1274,7 @@ namespace MiniScript {
 						if (value_equal(localStack[a], make_int(b))){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -858,6 +1286,7 @@ namespace MiniScript {
 						if (!value_equal(localStack[a], localStack[b])){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -869,6 +1298,7 @@ namespace MiniScript {
 						if (!value_equal(localStack[a], make_int(b))){
 							pc += offset;
 						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -876,6 +1306,9 @@ namespace MiniScript {
 						// if R[A] < R[B] is false, skip next instruction
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLT_INT_rA_rB);  // CPP: VM_REWRITE(IFLT_INT_rA_rB);  // quicken
+						}
 						if (!value_lt(localStack[a], localStack[b])) {
 							pc++; // Skip next instruction
 						}
@@ -886,6 +1319,9 @@ namespace MiniScript {
 						// if R[A] < BC (immediate) is false, skip next instruction
 						Byte a = BytecodeUtil.Au(instruction);
 						short bc = BytecodeUtil.BCs(instruction);
+						if (is_int(localStack[a])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLT_INT_rA_iBC);  // CPP: VM_REWRITE(IFLT_INT_rA_iBC);  // quicken
+						}
 						if (!value_lt(localStack[a], make_int(bc))) {
 							pc++; // Skip next instruction
 						}
@@ -906,6 +1342,9 @@ namespace MiniScript {
 						// if R[A] <= R[B] is false, skip next instruction
 						Byte a = BytecodeUtil.Au(instruction);
 						Byte b = BytecodeUtil.Bu(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLE_INT_rA_rB);  // CPP: VM_REWRITE(IFLE_INT_rA_rB);  // quicken
+						}
 						if (!value_le(localStack[a], localStack[b])) {
 							pc++; // Skip next instruction
 						}
@@ -916,6 +1355,9 @@ namespace MiniScript {
 						// if R[A] <= BC (immediate) is false, skip next instruction
 						Byte a = BytecodeUtil.Au(instruction);
 						short bc = BytecodeUtil.BCs(instruction);
+						if (is_int(localStack[a])) {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLE_INT_rA_iBC);  // CPP: VM_REWRITE(IFLE_INT_rA_iBC);  // quicken
+						}
 						if (!value_le(localStack[a], make_int(bc))) {
 							pc++; // Skip next instruction
 						}
@@ -977,48 +1419,28 @@ namespace MiniScript {
 						// ABC: number of ARG instructions that follow
 						Int32 argCount = BytecodeUtil.ABCs(instruction);
 
-						// Look ahead to find the CALL instruction (argCount instructions ahead)
-						Int32 callPC = pc + argCount;
-						if (callPC >= codeCount) {
-							RaiseRuntimeError("ARGBLK: CALL instruction out of range");
-							return make_null();
-						}
-						UInt32 callInstruction = curCode[callPC];
-						Opcode callOp = (Opcode)BytecodeUtil.OP(callInstruction);
-
-						// Extract call parameters based on opcode type
-						FuncDef callee = null; // CPP: FuncDef callee;
-						Int32 calleeBase = 0;
-						Int32 resultReg = -1;
+						// The CALL comes right after the ARGs (as the verifier ensures).
+						// CALL r[A], r[B], r[C]: invoke funcref in r[C], frame at r[B], result to r[A]
+						UInt32 callInstruction = curCode[pc + argCount];
+						Byte a = BytecodeUtil.Au(callInstruction);
+						Byte b = BytecodeUtil.Bu(callInstruction);
+						Byte c = BytecodeUtil.Cu(callInstruction);
 
-						if (callOp == Opcode.CALL_rA_rB_rC) {
-							// CALL r[A], r[B], r[C]: invoke funcref in r[C], frame at r[B], result to r[A]
-							Byte a = BytecodeUtil.Au(callInstruction);
-							Byte b = BytecodeUtil.Bu(callInstruction);
-							Byte c = BytecodeUtil.Cu(callInstruction);
-
-							Value funcRefValue = localStack[c];
-							if (!is_funcref(funcRefValue)) {
-								RaiseRuntimeError("ARGBLK/CALL: Not a function reference");
-								return make_null();
-							}
-
-							Int32 funcIndex = funcref_index(funcRefValue);
-							if (funcIndex < 0 || funcIndex >= functions.Count) {
-								RaiseRuntimeError("ARGBLK/CALL: Invalid function index");
-								return make_null();
-							}
-							callee = functions[funcIndex];
-							calleeBase = baseIndex + b;
-							resultReg = a;
-						} else {
-							RaiseRuntimeError("ARGBLK must be followed by CALL");
-							return make_null();
+						Value funcRefValue = localStack[c];
+						if (!is_funcref(funcRefValue)) {
+							RaiseRuntimeError("ARGBLK/CALL: Not a function reference");
+							break;
 						}
+						Int32 funcIndex = funcref_index(funcRefValue);
+						FuncDefPtr callee = functions[funcIndex];
+						Int32 calleeBase = baseIndex + b;
+						Int32 resultReg = a;
 
 						// Process arguments using helper
 						Int32 nextPC = ProcessArguments(argCount, pc, baseIndex, calleeBase, callee, ref curFunc.Code);
-						if (nextPC < 0) return make_null(); // Error already raised
+						if (nextPC < 0) {
+							break; // Error already raised
+						}
 
 						// Set up call frame using helper
 						SetupCallFrame(argCount, calleeBase, callee);
@@ -1026,37 +1448,39 @@ namespace MiniScript {
 						// Now execute the CALL (step 6): push CallInfo and switch to callee
 						if (callStackTop >= callStack.Count) {
 							RaiseRuntimeError("Call stack overflow");
-							return make_null();
+							break;
 						}
 
-						Int32 funcIndex2 = funcref_index(localStack[BytecodeUtil.Cu(callInstruction)]);
-						Value outerVars = funcref_outer_vars(localStack[BytecodeUtil.Cu(callInstruction)]);
-						callStack[callStackTop] = new CallInfo(nextPC, baseIndex, currentFuncIndex, resultReg, outerVars);
+						Value outerVars = funcref_outer_vars(funcRefValue);
+						callStack[callStackTop].SetReturn(nextPC, baseIndex, currentFuncIndex, curFunc, curCode, curConstants, resultReg, outerVars);
 						callStackTop++;
+						if (!callee.NamesAreStatic) callStack[callStackTop].LiveNames = true;
 
 						baseIndex = calleeBase;
 						pc = 0; // Start at beginning of callee code
 						curFunc = callee; // Switch to callee function
-						codeCount = curFunc.Code.Count;
-						curCode = curFunc.Code; // CPP: curCode = &curFunc.Code[0];
-						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc.Constants[0];
-						currentFuncIndex = funcIndex2;
+						curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
+						currentFuncIndex = funcIndex;
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
 						EnsureFrame(baseIndex, callee.MaxRegs);
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
 					case Opcode.ARG_rA: {
 						// The VM should never encounter this opcode on its own; it will
-						// be processed as part of the ARGBLK opcode.  So if we get
-						// here, it's an error.
+						// be processed as part of the ARGBLK opcode (and the verifier
+						// makes sure there's no other way to reach it).
 						RaiseRuntimeError("Internal error: ARG without ARGBLK");
 						return make_null();
 					}
 
 					case Opcode.ARG_iABC: {
 						// The VM should never encounter this opcode on its own; it will
-						// be processed as part of the ARGBLK opcode.  So if we get
-						// here, it's an error.
+						// be processed as part of the ARGBLK opcode (and the verifier
+						// makes sure there's no other way to reach it).
 						RaiseRuntimeError("Internal error: ARG without ARGBLK");
 						return make_null();
 					}
@@ -1066,35 +1490,77 @@ namespace MiniScript {
 						// BC: function index
 						Byte a = BytecodeUtil.Au(instruction);
 						UInt16 funcIndex = BytecodeUtil.BCu(instruction);
-						
-						if (funcIndex >= functions.Count) {
-							IOHelper.Print("CALLF to invalid func");
-							return make_null();
-						}
-						
-						FuncDef callee = functions[funcIndex];
+						FuncDefPtr callee = functions[funcIndex];
+
+						// (A callee that keeps names from the start finds those of
+						// its window in ours, so ours must be filled in.)
+						if (!callee.NamesAreStatic && !callStack[callStackTop].LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
 
 						// Push return info
 						if (callStackTop >= callStack.Count) {
-							IOHelper.Print("Call stack overflow");
+							PrintFault("Call stack overflow");
 							return make_null();
 						}
-						callStack[callStackTop] = new CallInfo(pc, baseIndex, currentFuncIndex);
+						callStack[callStackTop].SetReturn(pc, baseIndex, currentFuncIndex, curFunc, curCode, curConstants, -1, make_null());
 						callStackTop++;
+						if (!callee.NamesAreStatic) callStack[callStackTop].LiveNames = true;
 
 						// Switch to callee frame: base slides to argument window
 						baseIndex += a;
 						pc = 0; // Start at beginning of callee code
 						curFunc = callee; // Switch to callee function
-						codeCount = curFunc.Code.Count;
-						curCode = curFunc.Code; // CPP: curCode = &curFunc.Code[0];
-						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc.Constants[0];
+						curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
 						currentFuncIndex = funcIndex; // Switch to callee function index
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
 
 						EnsureFrame(baseIndex, callee.MaxRegs);
+						// Safepoint: each call (or return) charges the cycle budget one cycle
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 					
+					case Opcode.TAILCALLF_iA_iBC: {
+						// Like CALLF A, BC then RETURN, but reusing this call's frame:
+						// move the callee's window (from register A) down to r0, and
+						// run the callee in our place, so it returns to our caller.
+						// (The verifier keeps this out of @main.)
+						Byte a = BytecodeUtil.Au(instruction);
+						UInt16 funcIndex = BytecodeUtil.BCu(instruction);
+						FuncDefPtr callee = functions[funcIndex];
+						CallInfoRef frame = callStack[callStackTop];
+
+						// If we have a locals VarMap, gather it up first (as RETURN
+						// would), since our registers are about to be reused
+						if (!is_null(frame.LocalVarMap)) {
+							varmap_gather(frame.LocalVarMap);
+							frame.LocalVarMap = make_null();
+						}
+
+						// Move the window down, with its names if the callee keeps
+						// them (which, as for CALLF, are ours)
+						if (!callee.NamesAreStatic) {
+							if (!frame.LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
+							for (Int32 i = 0; i < callee.MaxRegs; i++) names[baseIndex + i] = names[baseIndex + a + i];
+						}
+						frame.LiveNames = !callee.NamesAreStatic;
+						for (Int32 i = 0; i < callee.MaxRegs; i++) localStack[i] = localStack[a + i];
+						callStack[callStackTop - 1].OuterVarMap = make_null();	// (as CALLF gives its callee)
+
+						pc = 0; // Start at beginning of callee code
+						curFunc = callee; // Switch to callee function
+						curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
+						currentFuncIndex = funcIndex; // Switch to callee function index
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
+
+						EnsureFrame(baseIndex, callee.MaxRegs);
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
 					case Opcode.CALLFN_iA_kBC: {
 						// Call named (intrinsic?) function kBC,
 						// with parameters/return at register A.
@@ -1104,6 +1570,7 @@ namespace MiniScript {
 						// For now, we'll only support intrinsics.
 						// ToDo: change this once we have variable look-up.
 						DoIntrinsic(funcName, baseIndex + a);
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -1120,17 +1587,13 @@ namespace MiniScript {
 
 						Value funcRefValue = localStack[c];
 						if (!is_funcref(funcRefValue)) {
-							IOHelper.Print("CALL: Value in register is not a function reference");
+							PrintFault("CALL: Value in register is not a function reference");
 							localStack[a] = funcRefValue;
 							break;
 						}
 
 						Int32 funcIndex = funcref_index(funcRefValue);
-						if (funcIndex < 0 || funcIndex >= functions.Count) {
-							IOHelper.Print("CALL: Invalid function index in FuncRef");
-							return make_null();
-						}
-						FuncDef callee = functions[funcIndex];
+						FuncDefPtr callee = functions[funcIndex];
 						Value outerVars = funcref_outer_vars(funcRefValue);
 
 						// For naked CALL (without ARGBLK): set up parameters with defaults
@@ -1138,21 +1601,24 @@ namespace MiniScript {
 						SetupCallFrame(0, calleeBase, callee); // 0 arguments, use all defaults
 
 						if (callStackTop >= callStack.Count) {
-							IOHelper.Print("Call stack overflow");
+							PrintFault("Call stack overflow");
 							return make_null();
 						}
-						callStack[callStackTop] = new CallInfo(pc, baseIndex, currentFuncIndex, a, outerVars);
+						callStack[callStackTop].SetReturn(pc, baseIndex, currentFuncIndex, curFunc, curCode, curConstants, a, outerVars);
 						callStackTop++;
+						if (!callee.NamesAreStatic) callStack[callStackTop].LiveNames = true;
 
 						// Set up call frame starting at baseIndex + b
 						baseIndex = calleeBase;
 						pc = 0; // Start at beginning of callee code
 						curFunc = callee; // Switch to callee function
-						codeCount = curFunc.Code.Count;
-						curCode = curFunc.Code; // CPP: curCode = &curFunc.Code[0];
-						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc.Constants[0];
+						curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
 						currentFuncIndex = funcIndex; // Switch to callee function index
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
 						EnsureFrame(baseIndex, callee.MaxRegs);
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -1164,7 +1630,7 @@ namespace MiniScript {
 							PC = pc;
 							BaseIndex = baseIndex;
 							_currentFuncIndex = currentFuncIndex;
-							CurrentFunction = curFunc;
+							CurrentFunction = functions[currentFuncIndex];
 							IsRunning = false;
 							return result;
 						}
@@ -1175,21 +1641,493 @@ namespace MiniScript {
 							varmap_gather(frame.LocalVarMap);
 							frame.LocalVarMap = make_null();  // then clear from call frame
 						}
+						frame.LiveNames = false;
 
 						// Pop call stack
 						callStackTop--;
-						CallInfo callInfo = callStack[callStackTop];
+						CallInfoRef callInfo = callStack[callStackTop];
 						pc = callInfo.ReturnPC;
 						baseIndex = callInfo.ReturnBase;
 						currentFuncIndex = callInfo.ReturnFuncIndex; // Restore the caller's function index
-						curFunc = functions[currentFuncIndex]; // Restore the caller's function
-						codeCount = curFunc.Code.Count;
-						curCode = curFunc.Code; // CPP: curCode = &curFunc.Code[0];
-						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc.Constants[0];
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
+						curFunc = callInfo.ReturnFunc; // Restore the caller's function
+						curCode = callInfo.ReturnCode;
+						curConstants = callInfo.ReturnConstants;
+						// CPP: stackTop = baseIndex + curFunc->MaxRegs;
 						
 						if (callInfo.CopyResultToReg >= 0) {
 							stack[baseIndex + callInfo.CopyResultToReg] = result;
 						}
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.FORPREP_rA_iBC: {
+						// Numeric for loop setup, with R[A] = counter, R[A+1] = limit,
+						// and R[A+2] = step: if the loop would run zero times, then
+						// PC += BC (to just past its FORLOOP); else fall into the body.
+						Byte a = BytecodeUtil.Au(instruction);
+						Value counter = localStack[a];
+						Value limit = localStack[a + 1];
+						Value step = localStack[a + 2];
+						if (is_int(counter) && is_int(limit) && is_int(step)) {
+							Int32 stepInt = as_int(step);
+							if (stepInt == 0) {
+								RaiseRuntimeError("for loop step is zero");
+								break;
+							}
+							if (stepInt > 0 ? as_int(counter) > as_int(limit) : as_int(counter) < as_int(limit)) {
+								pc += BytecodeUtil.BCs(instruction);
+							}
+						} else {
+							if (!is_number(counter) || !is_number(limit) || !is_number(step)) {
+								RaiseRuntimeError("for loop values must be numbers");
+								break;
+							}
+							if (value_equal(step, make_int(0))) {
+								RaiseRuntimeError("for loop step is zero");
+								break;
+							}
+							if (value_lt(make_int(0), step) ? value_lt(limit, counter) : value_lt(counter, limit)) {
+								pc += BytecodeUtil.BCs(instruction);
+							}
+						}
+						break;
+					}
+
+					case Opcode.FORLOOP_rA_iBC: {
+						// Numeric for loop step (see FORPREP): R[A] += R[A+2], and if
+						// that's still within R[A+1], then PC += BC (back to the body).
+						Byte a = BytecodeUtil.Au(instruction);
+						Value counter = localStack[a];
+						Value limit = localStack[a + 1];
+						Value step = localStack[a + 2];
+						if (is_int(counter) && is_int(limit) && is_int(step)) {
+							// (if this overflows Int32, it's also past the limit)
+							Int64 next = (Int64)as_int(counter) + as_int(step);
+							if (as_int(step) > 0 ? next <= as_int(limit) : next >= as_int(limit)) {
+								localStack[a] = make_int((Int32)next);
+								pc += BytecodeUtil.BCs(instruction);
+							}
+						} else {
+							Value next = value_add(counter, step);
+							if (value_lt(make_int(0), step) ? value_le(next, limit) : value_le(limit, next)) {
+								localStack[a] = next;
+								pc += BytecodeUtil.BCs(instruction);
+							}
+						}
+						if (BytecodeUtil.BCs(instruction) < 0 && (cyclesLeft += BytecodeUtil.BCs(instruction)) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.ITER_INIT_rA_rB: {
+						// Start iterating over the list, range, map, or string in R[B]:
+						// R[A] = R[B], and R[A+1] (the iterator state) = 0
+						Byte a = BytecodeUtil.Au(instruction);
+						Value container = localStack[BytecodeUtil.Bu(instruction)];
+						if (!is_list(container) && !is_range(container) && !is_map(container) && !is_string(container)) {
+							RaiseRuntimeError("can't iterate over this type");
+							break;
+						}
+						localStack[a] = container;
+						localStack[a + 1] = make_int(0);
+						break;
+					}
+
+					case Opcode.ITER_NEXT_rA_iBC: {
+						// Iteration step (see ITER_INIT): if R[A] has another element
+						// after state R[A+1], then put it in R[A+2] (and for a map,
+						// its value in R[A+3]), update the state, and PC += BC.
+						Byte a = BytecodeUtil.Au(instruction);
+						Value container = localStack[a];
+						// (The element goes straight into its register: in the tail-call
+						// build, taking the address of a local would cost us the tail call.)
+						Int32 state = as_int(localStack[a + 1]);
+						if (is_list(container)) {
+							state = list_iter_next(container, state, ref localStack[a + 2]); // CPP: state = list_iter_next(container, state, &localStack[a + 2]);
+						} else if (is_range(container)) {
+							state = range_iter_next(container, state, ref localStack[a + 2]); // CPP: state = range_iter_next(container, state, &localStack[a + 2]);
+						} else if (is_map(container)) {
+							state = map_iter_next(container, state, ref localStack[a + 2], ref localStack[a + 3]); // CPP: state = map_iter_next(container, state, &localStack[a + 2], &localStack[a + 3]);
+						} else {
+							state = string_iter_next(container, state, ref localStack[a + 2]); // CPP: state = string_iter_next(container, state, &localStack[a + 2]);
+						}
+						if (state >= 0) {
+							localStack[a + 1] = make_int(state);
+							pc += BytecodeUtil.BCs(instruction);
+						}
+						if (BytecodeUtil.BCs(instruction) < 0 && (cyclesLeft += BytecodeUtil.BCs(instruction)) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					// Quickened opcodes: each is a copy of a generic opcode above, specialized
+					// for the operand types that instruction has seen so far.  If the guard
+					// fails, it rewrites itself back to the generic opcode (deopt) and does
+					// the generic thing; the generic opcode may then quicken it again later.
+
+					case Opcode.ADD_INT_rA_rB_rC: {
+						// R[A] = R[B] + R[C], quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							Int64 result = (Int64)as_int(localStack[b]) + as_int(localStack[c]);
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.ADD_rA_rB_rC);  // CPP: VM_REWRITE(ADD_rA_rB_rC);  // deopt
+							localStack[a] = value_add(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.ADD_DBL_rA_rB_rC: {
+						// R[A] = R[B] + R[C], quickened for doubles
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_double(localStack[b]) && is_double(localStack[c])) {
+							localStack[a] = make_double(as_double(localStack[b]) + as_double(localStack[c]));
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.ADD_rA_rB_rC);  // CPP: VM_REWRITE(ADD_rA_rB_rC);  // deopt
+							localStack[a] = value_add(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.SUB_INT_rA_rB_rC: {
+						// R[A] = R[B] - R[C], quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							Int64 result = (Int64)as_int(localStack[b]) - as_int(localStack[c]);
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.SUB_rA_rB_rC);  // CPP: VM_REWRITE(SUB_rA_rB_rC);  // deopt
+							localStack[a] = value_sub(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.SUB_DBL_rA_rB_rC: {
+						// R[A] = R[B] - R[C], quickened for doubles
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_double(localStack[b]) && is_double(localStack[c])) {
+							localStack[a] = make_double(as_double(localStack[b]) - as_double(localStack[c]));
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.SUB_rA_rB_rC);  // CPP: VM_REWRITE(SUB_rA_rB_rC);  // deopt
+							localStack[a] = value_sub(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.MULT_INT_rA_rB_rC: {
+						// R[A] = R[B] * R[C], quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							Int64 result = (Int64)as_int(localStack[b]) * as_int(localStack[c]);
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.MULT_rA_rB_rC);  // CPP: VM_REWRITE(MULT_rA_rB_rC);  // deopt
+							localStack[a] = value_mult(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.MULT_DBL_rA_rB_rC: {
+						// R[A] = R[B] * R[C], quickened for doubles
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_double(localStack[b]) && is_double(localStack[c])) {
+							localStack[a] = make_double(as_double(localStack[b]) * as_double(localStack[c]));
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.MULT_rA_rB_rC);  // CPP: VM_REWRITE(MULT_rA_rB_rC);  // deopt
+							localStack[a] = value_mult(localStack[b], localStack[c]);
+						}
+						break;
+					}
+
+					case Opcode.LT_INT_rA_rB_rC: {
+						// R[A] = R[B] < R[C], quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							localStack[a] = make_int(as_int(localStack[b]) < as_int(localStack[c]));
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.LT_rA_rB_rC);  // CPP: VM_REWRITE(LT_rA_rB_rC);  // deopt
+							localStack[a] = make_int(value_lt(localStack[b], localStack[c]));
+						}
+						break;
+					}
+
+					case Opcode.LE_INT_rA_rB_rC: {
+						// R[A] = R[B] <= R[C], quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							localStack[a] = make_int(as_int(localStack[b]) <= as_int(localStack[c]));
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.LE_rA_rB_rC);  // CPP: VM_REWRITE(LE_rA_rB_rC);  // deopt
+							localStack[a] = make_int(value_le(localStack[b], localStack[c]));
+						}
+						break;
+					}
+
+					case Opcode.BRLT_INT_rA_rB_iC: {
+						// if R[A] < R[B] then jump offset C; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							if (as_int(localStack[a]) < as_int(localStack[b])) pc += offset;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLT_rA_rB_iC);  // CPP: VM_REWRITE(BRLT_rA_rB_iC);  // deopt
+							if (value_lt(localStack[a], localStack[b])) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.BRLT_INT_rA_iB_iC: {
+						// if R[A] < B (immediate) then jump offset C; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						SByte b = BytecodeUtil.Bs(instruction);
+						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a])) {
+							if (as_int(localStack[a]) < b) pc += offset;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLT_rA_iB_iC);  // CPP: VM_REWRITE(BRLT_rA_iB_iC);  // deopt
+							if (value_lt(localStack[a], make_int(b))) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.BRLE_INT_rA_rB_iC: {
+						// if R[A] <= R[B] then jump offset C; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							if (as_int(localStack[a]) <= as_int(localStack[b])) pc += offset;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLE_rA_rB_iC);  // CPP: VM_REWRITE(BRLE_rA_rB_iC);  // deopt
+							if (value_le(localStack[a], localStack[b])) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.BRLE_INT_rA_iB_iC: {
+						// if R[A] <= B (immediate) then jump offset C; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						SByte b = BytecodeUtil.Bs(instruction);
+						SByte offset = BytecodeUtil.Cs(instruction);
+						if (is_int(localStack[a])) {
+							if (as_int(localStack[a]) <= b) pc += offset;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.BRLE_rA_iB_iC);  // CPP: VM_REWRITE(BRLE_rA_iB_iC);  // deopt
+							if (value_le(localStack[a], make_int(b))) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.IFLT_INT_rA_rB: {
+						// if R[A] < R[B] is false, skip next instruction; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							if (!(as_int(localStack[a]) < as_int(localStack[b]))) pc++;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLT_rA_rB);  // CPP: VM_REWRITE(IFLT_rA_rB);  // deopt
+							if (!value_lt(localStack[a], localStack[b])) pc++;
+						}
+						break;
+					}
+
+					case Opcode.IFLT_INT_rA_iBC: {
+						// if R[A] < BC (immediate) is false, skip next instruction; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						short bc = BytecodeUtil.BCs(instruction);
+						if (is_int(localStack[a])) {
+							if (!(as_int(localStack[a]) < bc)) pc++;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLT_rA_iBC);  // CPP: VM_REWRITE(IFLT_rA_iBC);  // deopt
+							if (!value_lt(localStack[a], make_int(bc))) pc++;
+						}
+						break;
+					}
+
+					case Opcode.IFLE_INT_rA_rB: {
+						// if R[A] <= R[B] is false, skip next instruction; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						if (is_int(localStack[a]) && is_int(localStack[b])) {
+							if (!(as_int(localStack[a]) <= as_int(localStack[b]))) pc++;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLE_rA_rB);  // CPP: VM_REWRITE(IFLE_rA_rB);  // deopt
+							if (!value_le(localStack[a], localStack[b])) pc++;
+						}
+						break;
+					}
+
+					case Opcode.IFLE_INT_rA_iBC: {
+						// if R[A] <= BC (immediate) is false, skip next instruction; quickened for ints
+						Byte a = BytecodeUtil.Au(instruction);
+						short bc = BytecodeUtil.BCs(instruction);
+						if (is_int(localStack[a])) {
+							if (!(as_int(localStack[a]) <= bc)) pc++;
+						} else {
+							curCode[pc-1] = BytecodeUtil.WithOP(instruction, Opcode.IFLE_rA_iBC);  // CPP: VM_REWRITE(IFLE_rA_iBC);  // deopt
+							if (!value_le(localStack[a], make_int(bc))) pc++;
+						}
+						break;
+					}
+
+					// Superinstructions: each stands for the sequence of instructions
+					// it begins (see Assembler.FuseSuperinstructions), which are still
+					// there in the code after it.  So we read their operands from
+					// curCode[pc] onward, do the whole sequence, and then move pc past it.
+
+					case Opcode.IFLTI_RET: {
+						// LOAD rX, n; IFLT rA, rX; RETURN  (if R[A] < n then return)
+						Byte x = BytecodeUtil.Au(instruction);
+						short n = BytecodeUtil.BCs(instruction);
+						Byte a = BytecodeUtil.Au(curCode[pc]);
+						localStack[x] = make_int(n);
+						Boolean less;
+						if (is_int(localStack[a])) less = as_int(localStack[a]) < n;
+						else less = value_lt(localStack[a], localStack[x]);
+						if (less) {
+							pc++;		// go on to the RETURN
+						} else {
+							pc += 2;	// skip it
+						}
+						break;
+					}
+
+					case Opcode.SUBI_CALLF: {
+						// LOAD rX, n; SUB rA, rB, rX; CALLF iA, iBC
+						Byte x = BytecodeUtil.Au(instruction);
+						short n = BytecodeUtil.BCs(instruction);
+						UInt32 subInstruction = curCode[pc];
+						UInt32 callInstruction = curCode[pc+1];
+						pc += 2;
+						Byte a = BytecodeUtil.Au(subInstruction);
+						Byte b = BytecodeUtil.Bu(subInstruction);
+						localStack[x] = make_int(n);
+						if (is_int(localStack[b])) {
+							Int64 result = (Int64)as_int(localStack[b]) - n;
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							localStack[a] = value_sub(localStack[b], localStack[x]);
+						}
+
+						// Then the call, exactly as in CALLF_iA_iBC
+						Byte window = BytecodeUtil.Au(callInstruction);
+						UInt16 funcIndex = BytecodeUtil.BCu(callInstruction);
+						FuncDefPtr callee = functions[funcIndex];
+						if (!callee.NamesAreStatic && !callStack[callStackTop].LiveNames) StartLiveNames(curFunc, baseIndex, pc - 1);
+						if (callStackTop >= callStack.Count) {
+							PrintFault("Call stack overflow");
+							return make_null();
+						}
+						callStack[callStackTop].SetReturn(pc, baseIndex, currentFuncIndex, curFunc, curCode, curConstants, -1, make_null());
+						callStackTop++;
+						if (!callee.NamesAreStatic) callStack[callStackTop].LiveNames = true;
+
+						baseIndex += window;
+						pc = 0;
+						curFunc = callee;
+						curCode = curFunc.Code; // CPP: curCode = &curFunc->Code[0];
+						curConstants = curFunc.Constants; // CPP: curConstants = &curFunc->Constants[0];
+						currentFuncIndex = funcIndex;
+						// CPP: gc_alloc_site.function = currentFuncIndex;
+						// CPP: VM_SET_HANDLERS();
+
+						EnsureFrame(baseIndex, callee.MaxRegs);
+						if (--cyclesLeft <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.ADD_BRLT: {
+						// ADD rA, rB, rC; BRLT rD, rE, offset
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						UInt32 branchInstruction = curCode[pc++];
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							Int64 result = (Int64)as_int(localStack[b]) + as_int(localStack[c]);
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							localStack[a] = value_add(localStack[b], localStack[c]);
+						}
+						Byte d = BytecodeUtil.Au(branchInstruction);
+						Byte e = BytecodeUtil.Bu(branchInstruction);
+						SByte offset = BytecodeUtil.Cs(branchInstruction);
+						if (is_int(localStack[d]) && is_int(localStack[e])) {
+							if (as_int(localStack[d]) < as_int(localStack[e])) pc += offset;
+						} else {
+							if (value_lt(localStack[d], localStack[e])) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
+						break;
+					}
+
+					case Opcode.ADD_BRLE: {
+						// ADD rA, rB, rC; BRLE rD, rE, offset
+						Byte a = BytecodeUtil.Au(instruction);
+						Byte b = BytecodeUtil.Bu(instruction);
+						Byte c = BytecodeUtil.Cu(instruction);
+						UInt32 branchInstruction = curCode[pc++];
+						if (is_int(localStack[b]) && is_int(localStack[c])) {
+							Int64 result = (Int64)as_int(localStack[b]) + as_int(localStack[c]);
+							if (result >= Int32.MinValue && result <= Int32.MaxValue) {
+								localStack[a] = make_int((Int32)result);
+							} else {
+								localStack[a] = make_double((double)result);
+							}
+						} else {
+							localStack[a] = value_add(localStack[b], localStack[c]);
+						}
+						Byte d = BytecodeUtil.Au(branchInstruction);
+						Byte e = BytecodeUtil.Bu(branchInstruction);
+						SByte offset = BytecodeUtil.Cs(branchInstruction);
+						if (is_int(localStack[d]) && is_int(localStack[e])) {
+							if (as_int(localStack[d]) <= as_int(localStack[e])) pc += offset;
+						} else {
+							if (value_le(localStack[d], localStack[e])) pc += offset;
+						}
+						if (offset < 0 && (cyclesLeft += offset) <= 0) return Suspend(pc, baseIndex, currentFuncIndex);
 						break;
 					}
 
@@ -1201,7 +2139,7 @@ namespace MiniScript {
 						PC = pc;
 						BaseIndex = baseIndex;
 						_currentFuncIndex = currentFuncIndex;
-						CurrentFunction = curFunc;
+						CurrentFunction = functions[currentFuncIndex];
 						return make_null();
 				}
 //*** END CS_ONLY ***
@@ -1212,23 +2150,90 @@ namespace MiniScript {
 			PC = pc;
 			BaseIndex = baseIndex;
 			_currentFuncIndex = currentFuncIndex;
-			CurrentFunction = curFunc;
+			CurrentFunction = functions[currentFuncIndex];
 			return make_null();
 		}
 
-		private void EnsureFrame(Int32 baseIndex, UInt16 neededRegs) {
-			// Simple implementation - just check bounds
-			if (baseIndex + neededRegs > stack.Count) {
-				// Simple error handling - just print and continue
-				IOHelper.Print("Stack overflow error");
+		// Run exactly `steps` instructions (or until the program ends), for
+		// single-stepping in VMVis.
+		public Value Step(UInt32 steps=1) {
+			stepping = true;
+			stepsLeft = steps;
+			Value result = Run();
+			stepping = false;
+			return result;
+		}
+
+		// Stop before the instruction at pc in function funcIndex whenever Run
+		// gets there (setting AtBreakpoint); the next Run or Step resumes from
+		// that instruction.  Breakpoints are cleared by Reset.
+		public void SetBreakpoint(Int32 funcIndex, Int32 pc) {
+			if (funcIndex < 0 || funcIndex >= functions.Count) return;
+			if (functions[funcIndex].Breakpoints.Contains(pc)) return;
+			functions[funcIndex].Breakpoints.Add(pc);
+			breakpointCount++;
+		}
+
+		public void ClearBreakpoint(Int32 funcIndex, Int32 pc) {
+			if (funcIndex < 0 || funcIndex >= functions.Count) return;
+			if (functions[funcIndex].Breakpoints.Remove(pc)) breakpointCount--;
+		}
+
+		public void ClearBreakpoints() {
+			for (Int32 i = 0; i < functions.Count; i++) functions[i].Breakpoints.Clear();
+			breakpointCount = 0;
+		}
+
+		// Stop running at the given point, leaving the VM ready to resume
+		// there on the next Run.  (Returns the result of that Run: null.)
+		private Value Suspend(Int32 pc, Int32 baseIndex, Int32 currentFuncIndex) {
+			PC = pc;
+			BaseIndex = baseIndex;
+			_currentFuncIndex = currentFuncIndex;
+			CurrentFunction = functions[currentFuncIndex];
+			return make_null();
+		}
+
+		// Clear (to null) the registers of callee's new frame at calleeBase
+		// that it might read before writing them (see FuncDef.MustClear),
+		// each run of them in one go.  Its parameters are left alone.
+		private void ClearRegisters(FuncDefPtr callee, Int32 calleeBase) {
+			if (!callee.MustClearIsKnown) {
+				stack[calleeBase] = make_null();
+				for (Int32 i = callee.ParamNames.Count + 1; i < callee.MaxRegs; i++) stack[calleeBase + i] = make_null();
+				return;
+			}
+			for (Int32 i = 0; i < callee.MustClear.Count; i++) {
+				RegisterRun run = callee.MustClear[i]; // CPP: RegisterRun& run = callee->MustClear[i];
+				CollectionsMarshal.AsSpan(stack).Slice(calleeBase + run.Start, run.End - run.Start).Fill(make_null()); // CPP: std::fill_n(&stack[calleeBase + run.Start], run.End - run.Start, make_null());
+			}
+		}
+
+		// Start keeping names[] for the current frame, whose function has
+		// static names (see FuncDef.NamesAreStatic): fill in its registers'
+		// names as they are just before the instruction at pc.
+		[Cold]
+		private void StartLiveNames(FuncDefPtr func, Int32 baseIndex, Int32 pc) {
+			for (Int32 i = 0; i < func.MaxRegs; i++) names[baseIndex + i] = make_null();
+			for (Int32 i = 0; i < func.RegisterNames.Count; i++) {
+				RegisterName entry = func.RegisterNames[i]; // CPP: RegisterName& entry = func->RegisterNames[i];
+				if (pc >= entry.StartPC && pc < entry.EndPC) names[baseIndex + entry.Reg] = entry.Name;
 			}
+			callStack[callStackTop].LiveNames = true;
+		}
+
+		private void EnsureFrame(Int32 baseIndex, UInt16 neededRegs) {
+			// CPP: stackTop = baseIndex + neededRegs;	// (registers the GC must scan)
+			// CPP: if (stackTop > stackHighWater) stackHighWater = stackTop;
+			// (No need to check that against the stack size: Reset made sure
+			// the stack can hold as deep a call stack as there can be.)
 		}
 
 		private Value LookupVariable(Value varName) {
 			// Look up a variable in outer context (and eventually globals)
 			// Returns the value if found, or null if not found
 			if (callStackTop > 0) {
-				CallInfo currentFrame = callStack[callStackTop - 1];  // Current frame, not next frame
+				CallInfoRef currentFrame = callStack[callStackTop - 1];  // Current frame, not next frame
 				if (!is_null(currentFrame.OuterVarMap)) {
 					Value outerValue;
 					if (map_try_get(currentFrame.OuterVarMap, varName, out outerValue)) {
@@ -1248,6 +2253,8 @@ namespace MiniScript {
 		private static readonly Value FuncNameInput = make_string("input");
 		private static readonly Value FuncNameVal = make_string("val");
 		private static readonly Value FuncNameRemove = make_string("remove");
+		private static readonly Value FuncNameRange = make_string("range");
+		private static readonly Value FuncNameLen = make_string("len");
 		
 		private void DoIntrinsic(Value funcName, Int32 baseReg) {
 			// Run the named intrinsic, with its parameters and return value
@@ -1276,6 +2283,7 @@ namespace MiniScript {
 				// 0 if index not found.
 				Value container = stack[baseReg];
 				int result = 0;
+				if (is_range(container)) container = range_to_list(container);
 				if (is_list(container)) {
 					result = list_remove(container, as_int(stack[baseReg+1])) ? 1 : 0;
 				} else if (is_map(container)) {
@@ -1285,6 +2293,35 @@ namespace MiniScript {
 				}
 				stack[baseReg] = make_int(result);
 			
+			} else if (value_equal(funcName, FuncNameRange)) {
+				// Return (in r0) a range from r0 to r1 inclusive, by step r2
+				// (or by 1 or -1, if r2 is null).  This is a compact stand-in
+				// for the list of those numbers; see value_range.h.
+				Value step = stack[baseReg+2];
+				if (!is_number(stack[baseReg]) || !is_number(stack[baseReg+1])
+				  || (!is_null(step) && !is_number(step))) {
+					RaiseRuntimeError("range() arguments must be numbers");
+				} else if (!is_null(step) && value_equal(step, make_int(0))) {
+					RaiseRuntimeError("range() step must not be 0");
+				} else {
+					stack[baseReg] = make_range(stack[baseReg], stack[baseReg+1], step);
+				}
+			
+			} else if (value_equal(funcName, FuncNameLen)) {
+				// Return (in r0) the length of the list, range, string, or map in r0
+				Value container = stack[baseReg];
+				if (is_list(container)) {
+					stack[baseReg] = make_int(list_count(container));
+				} else if (is_range(container)) {
+					stack[baseReg] = make_int(range_count(container));
+				} else if (is_string(container)) {
+					stack[baseReg] = make_int(string_length(container));
+				} else if (is_map(container)) {
+					stack[baseReg] = make_int(map_count(container));
+				} else {
+					stack[baseReg] = make_null();
+				}
+			
 			} else {
 				IOHelper.Print(
 				  StringUtils.Format("ERROR: Unknown function '{0}'", funcName)
@@ -120,15 +120,35 @@ namespace MiniScript {
 			String header = Bold + func.Name + Normal;
 			Write(StringUtils.SpacePad(header, 32));
 
-			// Draw code, with current line in bold
+			// Draw code, with current line in bold.  A superinstruction is shown
+			// as the instruction it replaced, marked with "+", and the rest of
+			// the sequence it covers is marked with "|".
 			Int32 startLine = Math.Max(0, pc - (_screenHeight - 4) / 2);
 			Int32 endLine = Math.Min(func.Code.Count - 1, startLine + _screenHeight - 4);
 
+			// (start with any sequence begun above the first line shown)
+			Int32 fusedEnd = 0;
+			for (Int32 i = Math.Max(0, startLine - 2); i < startLine; i++) {
+				Opcode op = (Opcode)BytecodeUtil.OP(func.Code[i]);
+				Int32 len = BytecodeUtil.FusedLength(op);
+				if (len > 1 && i + len > fusedEnd) fusedEnd = i + len;
+			}
+
 			for (Int32 i = startLine; i <= endLine; i++) {
 				String prefix = (i == pc) ? "PC: " + Bold : "    ";
 				String addr = StringUtils.ZeroPad(i, 4);
-				String instruction = Disassembler.ToString(func.Code[i]);
-				String line = prefix + addr + ": " + instruction;
+				UInt32 code = func.Code[i];
+				Opcode op = (Opcode)BytecodeUtil.OP(code);
+				String mark = " ";
+				if (i < fusedEnd) {
+					mark = "|";
+				} else if (BytecodeUtil.FusedLength(op) > 1) {
+					mark = "+";
+					fusedEnd = i + BytecodeUtil.FusedLength(op);
+					code = BytecodeUtil.WithOP(code, BytecodeUtil.UnfusedOP(op));
+				}
+				String instruction = Disassembler.ToString(code);
+				String line = prefix + addr + ":" + mark + instruction;
 				if (i == pc) line += Normal;
 
 				GoTo(CodeDisplayColumn + 1, i - startLine + 2);
@@ -150,6 +170,7 @@ namespace MiniScript {
 			if (is_double(v)) return "dbl";
 			if (is_string(v)) return "str";
 			if (is_list(v)) return "lst";
+			if (is_range(v)) return "rng";
 			if (is_map(v)) return "map";
 			if (is_funcref(v)) return "fun";
 			return "unk";
@@ -30,6 +30,7 @@ namespace MiniScript {
 		// High 16 bits used to tag NaN-ish payloads.
 		private const ulong NANISH_MASK     = 0xFFFF_0000_0000_0000UL;
 		private const ulong val_null      = 0xFFF1_0000_0000_0000UL; // null singleton (our lowest reserved NaN pattern)
+		private const ulong RANGE_TAG       = 0xFFF9_0000_0000_0000UL; // range tag
 		private const ulong INTEGER_TAG     = 0xFFFA_0000_0000_0000UL; // Int32 tag
 		private const ulong FUNCREF_TAG     = 0xFFFB_0000_0000_0000UL; // function reference tag
 		private const ulong MAP_TAG         = 0xFFFC_0000_0000_0000UL; // map tag
@@ -87,6 +88,12 @@ namespace MiniScript {
 			return FromHandle(MAP_TAG, h);
 		}
 
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static Value FromRange(ValueRange range) {
+			int h = HandlePool.Add(range);
+			return FromHandle(RANGE_TAG, h);
+		}
+
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		public static Value FromFuncRef(ValueFuncRef funcRefObj) {
 			int h = HandlePool.Add(funcRefObj);
@@ -106,6 +113,7 @@ namespace MiniScript {
 		public bool IsFuncRef { [MethodImpl(MethodImplOptions.AggressiveInlining)] get => (_u & NANISH_MASK) == FUNCREF_TAG; }
 		public bool IsList   { [MethodImpl(MethodImplOptions.AggressiveInlining)] get => (_u & NANISH_MASK) == LIST_TAG; }
 		public bool IsMap	{ [MethodImpl(MethodImplOptions.AggressiveInlining)] get => (_u & NANISH_MASK) == MAP_TAG; }
+		public bool IsRange  { [MethodImpl(MethodImplOptions.AggressiveInlining)] get => (_u & NANISH_MASK) == RANGE_TAG; }
 		public bool IsDouble { [MethodImpl(MethodImplOptions.AggressiveInlining)] get => (_u & NANISH_MASK) < val_null; }
 
 		// ==== ACCESSORS =======================================================
@@ -178,6 +186,15 @@ namespace MiniScript {
 
 				return "{" + string.Join(", ", items) + "}";
 			}
+			if (IsRange) {
+				var range = HandlePool.Get(Handle()) as ValueRange;
+				if (range == null) return "<range?>";
+				if (!range.List.IsNull) return range.List.ToString();
+
+				var items = new string[range.Count];
+				for (int i = 0; i < range.Count; i++) items[i] = range.Get(i).ToString();
+				return "[" + string.Join(", ", items) + "]";
+			}
 			if (IsFuncRef) {
 				var funcRefObj = AsFuncRefObject();
 				if (funcRefObj == null) return "<funcref?>";
@@ -193,7 +210,7 @@ namespace MiniScript {
 		public static Value Add(Value a, Value b) {
 			if (a.IsInt && b.IsInt) {
 				long r = (long)a.AsInt() + b.AsInt();
-				if ((uint)r == r) return FromInt((int)r);
+				if (r >= int.MinValue && r <= int.MaxValue) return FromInt((int)r);
 				return FromDouble((double)r);
 			}
 			if ((a.IsInt || a.IsDouble) && (b.IsInt || b.IsDouble)) {
@@ -216,7 +233,7 @@ namespace MiniScript {
 		public static Value Multiply(Value a, Value b) {
 			if (a.IsInt && b.IsInt) {
 				long r = (long)a.AsInt() * b.AsInt();
-				if ((uint)r == r) return FromInt((int)r);
+				if (r >= int.MinValue && r <= int.MaxValue) return FromInt((int)r);
 				return FromDouble((double)r);
 			}
 			if (is_number(a) && is_number(b)) {
@@ -263,7 +280,7 @@ namespace MiniScript {
 		public static Value Divide(Value a, Value b) {
 			if (a.IsInt && b.IsInt) {
 				long r = (long)a.AsInt() / b.AsInt();
-				if ((uint)r == r) return FromInt((int)r);
+				if (r >= int.MinValue && r <= int.MaxValue) return FromInt((int)r);
 				return FromDouble((double)r);
 			}
 			if ((a.IsInt || a.IsDouble) && (b.IsInt || b.IsDouble)) {
@@ -283,7 +300,7 @@ namespace MiniScript {
 		public static Value Mod(Value a, Value b) {
 			if (a.IsInt && b.IsInt) {
 				long r = (long)a.AsInt() % b.AsInt();
-				if ((uint)r == r) return FromInt((int)r);
+				if (r >= int.MinValue && r <= int.MaxValue) return FromInt((int)r);
 				return FromDouble((double)r);
 			}
 			if ((a.IsInt || a.IsDouble) && (b.IsInt || b.IsDouble)) {
@@ -387,7 +404,7 @@ namespace MiniScript {
 	public static class ValueHelpers {
 
 		// Common constant values (matching value.h)
-		public static Value val_null = val_null;
+		public static Value val_null = Value.Null();
 		public static Value val_zero = Value.FromInt(0);
 		public static Value val_one = Value.FromInt(1);
 		public static Value val_empty_string = Value.FromString("");
@@ -446,6 +463,16 @@ namespace MiniScript {
 			valueList?.Add(item);
 		}
 
+		// List iteration: start with state 0; each call returns the next state
+		// and the item, or -1 (leaving item alone) when there are no more items.
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static int list_iter_next(Value list_val, int state, ref Value item) {
+			var valueList = HandlePool.Get(list_val.Handle()) as ValueList;
+			if (valueList == null || state >= valueList.Count) return -1;
+			item = valueList.Get(state);
+			return state + 1;
+		}
+
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		public static bool list_remove(Value list_val, int index) {
 			if (!list_val.IsList) return false;
@@ -453,6 +480,57 @@ namespace MiniScript {
 			return valueList != null ? valueList.Remove(index) : false;
 		}
 
+		// Range functions (matching value_range.h)
+		public static Value make_range(Value start, Value stop, Value step) {
+			return Value.FromRange(new ValueRange(start, stop, step));
+		}
+
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static int range_count(Value range_val) {
+			if (!range_val.IsRange) return 0;
+			var range = HandlePool.Get(range_val.Handle()) as ValueRange;
+			if (range == null) return 0;
+			if (!range.List.IsNull) return list_count(range.List);
+			return range.Count;
+		}
+
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static Value range_get(Value range_val, int index) {
+			if (!range_val.IsRange) return make_null();
+			var range = HandlePool.Get(range_val.Handle()) as ValueRange;
+			if (range == null) return make_null();
+			int count = range.List.IsNull ? range.Count : list_count(range.List);
+			if (index < 0) index += count;
+			if (index < 0 || index >= count) return make_null();
+			if (!range.List.IsNull) return list_get(range.List, index);
+			return range.Get(index);
+		}
+
+		// Range iteration: start with state 0; each call returns the next state
+		// and the element, or -1 (leaving item alone) when there are no more.
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static int range_iter_next(Value range_val, int state, ref Value item) {
+			var range = HandlePool.Get(range_val.Handle()) as ValueRange;
+			if (range != null && !range.List.IsNull) return list_iter_next(range.List, state, ref item);
+			if (range == null || state >= range.Count) return -1;
+			item = range.Get(state);
+			return state + 1;
+		}
+
+		// Materialize a range into a list with the same elements (before mutating
+		// it); the range keeps that list and defers to it from then on
+		public static Value range_to_list(Value range_val) {
+			if (!range_val.IsRange) return make_null();
+			var range = HandlePool.Get(range_val.Handle()) as ValueRange;
+			if (range == null) return make_null();
+			if (range.List.IsNull) {
+				Value list = make_list(range.Count);
+				for (int i = 0; i < range.Count; i++) list_push(list, range.Get(i));
+				range.List = list;
+			}
+			return range.List;
+		}
+
 		// Map functions (matching value_map.h)
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		public static Value make_map(int initial_capacity) {
@@ -530,12 +608,35 @@ namespace MiniScript {
 			valueMap?.Clear();
 		}
 		
+		// Map iteration: start with state 0; each call returns the next state,
+		// key, and value, or -1 (leaving key and value alone) when there are no more.
+		public static int map_iter_next(Value map_val, int state, ref Value key, ref Value value) {
+			var valueMap = HandlePool.Get(map_val.Handle()) as ValueMap;
+			if (valueMap == null) return -1;
+			return valueMap.IterNext(state, ref key, ref value);
+		}
+
 		public static void varmap_gather(Value map_val) {
 			if (!map_val.IsMap) return;
 			var varMap = HandlePool.Get(map_val.Handle()) as VarMap;
 			varMap?.Gather();
 		}
 
+		// String functions (matching value_string.h)
+		public static int string_length(Value str) => StringLength(str);
+
+		// String iteration, one character at a time: the state is the index of
+		// the next character (in UTF-16 units, so a surrogate pair is stepped
+		// over as one).  Returns the next state, or -1 (leaving ch alone) when
+		// there are no more.
+		public static int string_iter_next(Value str, int state, ref Value ch) {
+			string s = GetStringValue(str);
+			if (state >= s.Length) return -1;
+			int len = (Char.IsHighSurrogate(s[state]) && state + 1 < s.Length) ? 2 : 1;
+			ch = make_string(s.Substring(state, len));
+			return state + len;
+		}
+
 		// Value representation function (for literal representation)
 		public static Value value_repr(Value v) {
 			if (v.IsString) {
@@ -575,6 +676,9 @@ namespace MiniScript {
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		public static bool is_list(Value v) => v.IsList;
 
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static bool is_range(Value v) => v.IsRange;
+
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		public static bool is_funcref(Value v) => v.IsFuncRef;
 
@@ -705,37 +809,143 @@ namespace MiniScript {
 		}
 	}
 
+	// Compares map keys the way Value.Equal does (heap strings by content,
+	// numbers by numeric value), rather than by their bits.
+	public sealed class ValueKeyComparer : IEqualityComparer<Value> {
+		public static readonly ValueKeyComparer Instance = new ValueKeyComparer();
+
+		public bool Equals(Value a, Value b) => Value.Equal(a, b);
+
+		public int GetHashCode(Value v) {
+			if (v.IsHeapString) return GetStringValue(v).GetHashCode();
+			if (v.IsInt || v.IsDouble) return (v.IsInt ? v.AsInt() : v.AsDouble()).GetHashCode();
+			return v.Bits.GetHashCode();
+		}
+	}
+
+	// An evenly spaced sequence of numbers (see value_range.h), until it's
+	// changed; then it becomes (and defers to) a real list
+	public class ValueRange {
+		public readonly double Start;
+		public readonly double Stop;
+		public readonly double Step;	// (never 0)
+		public readonly int Count;
+		public readonly bool Ints;		// true if start and step are ints (so the elements are too)
+		public Value List = Value.Null();	// the list this range has become (see range_to_list), or null
+
+		public ValueRange(Value start, Value stop, Value step) {
+			Start = start.IsInt ? start.AsInt() : start.AsDouble();
+			Stop = stop.IsInt ? stop.AsInt() : stop.AsDouble();
+			if (step.IsNull) {
+				Step = (Stop >= Start ? 1 : -1);
+				Ints = start.IsInt;
+			} else {
+				Step = step.IsInt ? step.AsInt() : step.AsDouble();
+				Ints = start.IsInt && step.IsInt;
+			}
+			double count = Math.Floor((Stop - Start) / Step) + 1;
+			if (!(count > 0)) count = 0;  // (also catches NaN)
+			Count = (count > Int32.MaxValue ? Int32.MaxValue : (int)count);
+		}
+
+		// Element index (0 <= index < Count)
+		public Value Get(int index) {
+			double d = Start + Step * index;
+			if (Ints && d >= Int32.MinValue && d <= Int32.MaxValue) return Value.FromInt((int)d);
+			return Value.FromDouble(d);
+		}
+	}
+
 	public class ValueMap {
-		protected Dictionary<Value, Value> _items = new Dictionary<Value, Value>();
+		// Entries are kept in slots, in the order they were added; removing one
+		// leaves an empty slot (until there are enough to be worth compacting).
+		// _slots maps each key to its slot, and lets iteration walk the slots by
+		// index, with the state in a single int (see map_iter_next).
+		protected Dictionary<Value, int> _slots = new Dictionary<Value, int>(ValueKeyComparer.Instance);
+		private List<Value> _keys = new List<Value>();
+		private List<Value> _values = new List<Value>();
+		private List<bool> _occupied = new List<bool>();
 
-		public virtual int Count => _items.Count;
+		public virtual int Count => _slots.Count;
 
 		public virtual Value Get(Value key) {
-			if (_items.TryGetValue(key, out Value value)) {
-				return value;
+			if (_slots.TryGetValue(key, out int slot)) {
+				return _values[slot];
 			}
 			return val_null;
 		}
 
 		public virtual bool Set(Value key, Value value) {
-			_items[key] = value;
+			if (_slots.TryGetValue(key, out int slot)) {
+				_values[slot] = value;
+				return true;
+			}
+			if (_keys.Count >= 16 && _slots.Count < _keys.Count / 2) Compact();
+			_slots[key] = _keys.Count;
+			_keys.Add(key);
+			_values.Add(value);
+			_occupied.Add(true);
 			return true;
 		}
 
 		public virtual bool Remove(Value key) {
-			return _items.Remove(key);
+			if (!_slots.TryGetValue(key, out int slot)) return false;
+			_slots.Remove(key);
+			_keys[slot] = val_null;
+			_values[slot] = val_null;
+			_occupied[slot] = false;
+			return true;
 		}
 
 		public virtual bool HasKey(Value key) {
-			return _items.ContainsKey(key);
+			return _slots.ContainsKey(key);
 		}
 
 		public virtual void Clear() {
-			_items.Clear();
+			_slots.Clear();
+			_keys.Clear();
+			_values.Clear();
+			_occupied.Clear();
+		}
+
+		// Close up the empty slots left by removals
+		private void Compact() {
+			int j = 0;
+			for (int i = 0; i < _keys.Count; i++) {
+				if (!_occupied[i]) continue;
+				_keys[j] = _keys[i];
+				_values[j] = _values[i];
+				_slots[_keys[j]] = j;
+				j++;
+			}
+			int removed = _keys.Count - j;
+			_keys.RemoveRange(j, removed);
+			_values.RemoveRange(j, removed);
+			_occupied.RemoveRange(j, removed);
+			for (int i = 0; i < j; i++) _occupied[i] = true;
 		}
 
 		// For iteration support
-		public virtual IEnumerable<KeyValuePair<Value, Value>> Items => _items;
+		public virtual IEnumerable<KeyValuePair<Value, Value>> Items {
+			get {
+				for (int i = 0; i < _keys.Count; i++) {
+					if (_occupied[i]) yield return new KeyValuePair<Value, Value>(_keys[i], _values[i]);
+				}
+			}
+		}
+
+		// Iteration with the state in a single int (see map_iter_next): the
+		// index of the next slot to look at.  Each loop keeps its own state, so
+		// loops over the same map don't interfere.
+		public virtual int IterNext(int state, ref Value key, ref Value value) {
+			for (int i = state; i < _keys.Count; i++) {
+				if (!_occupied[i]) continue;
+				key = _keys[i];
+				value = _values[i];
+				return i + 1;
+			}
+			return -1;
+		}
 	}
 
 	// String operations
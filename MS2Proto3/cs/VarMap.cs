@@ -31,6 +31,7 @@ namespace MiniScript {
 	/// </summary>
 	public class VarMap : ValueMap {
 		private Dictionary<Value, int> _regMap = new Dictionary<Value, int>(new ValueEqualityComparer());
+		private List<Value> _regKeys = new List<Value>();  // Keys of _regMap, in the order added
 		private List<Value> _registers;  // Reference to VM's register array
 		private List<Value> _names;      // Reference to VM's register names array
 
@@ -38,7 +39,7 @@ namespace MiniScript {
 			_registers = registers;
 			_names = names;
 			for (int i = firstIdx; i <= lastIdx; i++) {
-				if (!_names[i].IsNull) _regMap[_names[i]] = i;
+				if (!_names[i].IsNull) MapToRegister(_names[i], i);
 			}
 		}
 
@@ -47,6 +48,7 @@ namespace MiniScript {
 		/// This creates the special register-backed behavior for this key.
 		/// </summary>
 		public void MapToRegister(Value varName, int regIndex) {
+			if (!_regMap.ContainsKey(varName)) _regKeys.Add(varName);
 			_regMap[varName] = regIndex;
 		}
 
@@ -127,7 +129,8 @@ namespace MiniScript {
 			}
 
 			// Clear all register mappings
-			_regMap.Clear();			
+			_regMap.Clear();
+			_regKeys.Clear();
 		}
 
 		/// <summary>
@@ -143,6 +146,24 @@ namespace MiniScript {
 			}
 		}
 
+		/// <summary>
+		/// Iterate over the register-mapped variables (states 0 through the
+		/// number of them), then the regular map entries (states past that).
+		/// </summary>
+		public override int IterNext(int state, ref Value key, ref Value value) {
+			int regCount = _regKeys.Count;
+			for (; state < regCount; state++) {
+				int regIndex = _regMap[_regKeys[state]];
+				if (!_names[regIndex].IsNull) {
+					key = _regKeys[state];
+					value = _registers[regIndex];
+					return state + 1;
+				}
+			}
+			int next = base.IterNext(state - regCount, ref key, ref value);
+			return next < 0 ? -1 : next + regCount;
+		}
+
 		/// <summary>
 		/// Enumerate over both register-mapped variables and regular map entries.
 		/// </summary>
@@ -0,0 +1,293 @@
+using System;
+using System.Collections.Generic;
+// CPP: #include "Bytecode.g.h"
+// CPP: #include "FuncDef.g.h"
+// CPP: #include "StringUtils.g.h"
+// CPP: #include "CS_Math.h"
+
+namespace MiniScript {
+
+	// Load-time checks on bytecode, done once per function before the VM
+	// runs any of it (see VM.Reset).  Code that passes can't name a register
+	// outside its frame, a constant or function that doesn't exist, or an
+	// ARG outside a well-formed ARGBLK; nor can it branch or fall out of its
+	// code.  So the VM doesn't check any of those things as it runs.
+	public static class Verifier {
+
+		// Check all the given functions.  Return "" if they're all good, or
+		// else a description of the first problem found.
+		public static String Verify(List<FuncDef> functions) {
+			// (a call frame keeps its caller's index in an Int16)
+			if (functions.Count > Int16.MaxValue) return "too many functions";
+			for (Int32 i = 0; i < functions.Count; i++) {
+				String err = VerifyFunction(functions[i], functions);
+				if (err != "") return StringUtils.Format("{0}: {1}", functions[i].Name, err);
+			}
+			return "";
+		}
+
+		// Return how far (in registers) any call in the given functions moves
+		// the register window.  The deepest the register stack can get is then
+		// this times the call depth, plus one frame.
+		public static Int32 MaxCallWindow(List<FuncDef> functions) {
+			Int32 result = 0;
+			for (Int32 f = 0; f < functions.Count; f++) {
+				FuncDef func = functions[f];
+				for (Int32 pc = 0; pc < func.Code.Count; pc++) {
+					UInt32 instruction = func.Code[pc];
+					Opcode op = BytecodeUtil.UnfusedOP((Opcode)BytecodeUtil.OP(instruction));
+					Int32 window = 0;
+					if (op == Opcode.CALLF_iA_iBC || op == Opcode.TAILCALLF_iA_iBC) window = BytecodeUtil.Au(instruction);
+					else if (op == Opcode.CALL_rA_rB_rC) window = BytecodeUtil.Bu(instruction);
+					else if (op == Opcode.LOADC_rA_rB_kC) window = func.MaxRegs;
+					if (window > result) result = window;
+				}
+			}
+			return result;
+		}
+
+		private static String VerifyFunction(FuncDef func, List<FuncDef> functions) {
+			List<UInt32> code = func.Code;
+			Int32 count = code.Count;
+			if (count == 0) return "no code";
+			if (func.MaxRegs > 256) return "too many registers";
+			if (func.ParamNames.Count > 0 && func.MaxRegs <= func.ParamNames.Count) {
+				return "too few registers for its parameters";
+			}
+
+			// First find the ARG instructions that belong to an ARGBLK (the
+			// only place the VM should ever come across them).
+			List<Boolean> isBlockArg = new List<Boolean>();
+			for (Int32 pc = 0; pc < count; pc++) isBlockArg.Add(false);
+			for (Int32 pc = 0; pc < count; pc++) {
+				UInt32 instruction = code[pc];
+				if ((Opcode)BytecodeUtil.OP(instruction) != Opcode.ARGBLK_iABC) continue;
+				Int32 argCount = BytecodeUtil.ABCs(instruction);
+				if (argCount < 0 || pc + argCount + 1 >= count) return AtPC(pc, "ARGBLK runs past end of code");
+				for (Int32 i = 1; i <= argCount; i++) {
+					Opcode argOp = (Opcode)BytecodeUtil.OP(code[pc + i]);
+					if (argOp != Opcode.ARG_rA && argOp != Opcode.ARG_iABC) return AtPC(pc + i, "ARGBLK needs an ARG here");
+					isBlockArg[pc + i] = true;
+				}
+				Opcode callOp = (Opcode)BytecodeUtil.OP(code[pc + argCount + 1]);
+				if (callOp != Opcode.CALL_rA_rB_rC) return AtPC(pc + argCount + 1, "ARGBLK must be followed by CALL");
+			}
+
+			// Then check each instruction's operands, and where it can go next.
+			for (Int32 pc = 0; pc < count; pc++) {
+				UInt32 instruction = code[pc];
+				Byte opByte = BytecodeUtil.OP(instruction);
+				if (opByte >= (Byte)Opcode.OP__COUNT) return AtPC(pc, "invalid opcode");
+				// (A superinstruction's operands are those of the instruction
+				// it replaced; the rest of its sequence is checked on its own.)
+				Opcode op = BytecodeUtil.UnfusedOP((Opcode)opByte);
+				Byte a = BytecodeUtil.Au(instruction);
+				Byte b = BytecodeUtil.Bu(instruction);
+				Byte c = BytecodeUtil.Cu(instruction);
+				Int32 maxReg = -1;			// highest register used
+				Int32 constIdx = -1;		// constant used, if any
+				Boolean branches = false;	// whether it may go to target
+				Int32 target = 0;			// (branch target, or past a skipped instruction)
+				Boolean fallsThrough = true;	// whether it may go on to pc + 1
+				switch (op) {
+					case Opcode.NOOP:
+						break;
+
+					case Opcode.LOAD_rA_rB:
+					case Opcode.PUSH_rA_rB:
+						maxReg = Math.Max(a, b);
+						break;
+
+					case Opcode.LOAD_rA_iBC:
+					case Opcode.LIST_rA_iBC:
+					case Opcode.MAP_rA_iBC:
+					case Opcode.LOCALS_rA:
+					case Opcode.OUTER_rA:
+					case Opcode.GLOBALS_rA:
+					case Opcode.ARG_rA:
+						maxReg = a;
+						break;
+
+					case Opcode.LOAD_rA_kBC:
+					case Opcode.NAME_rA_kBC:
+						maxReg = a;
+						constIdx = BytecodeUtil.BCu(instruction);
+						break;
+
+					case Opcode.LOADV_rA_rB_kC:
+					case Opcode.LOADC_rA_rB_kC:
+					case Opcode.ASSIGN_rA_rB_kC:
+						maxReg = Math.Max(a, b);
+						constIdx = c;
+						break;
+
+					case Opcode.FUNCREF_iA_iBC:
+						maxReg = a;
+						if (BytecodeUtil.BCu(instruction) >= functions.Count) return AtPC(pc, "invalid function index");
+						break;
+
+					case Opcode.ADD_rA_rB_rC:
+					case Opcode.SUB_rA_rB_rC:
+					case Opcode.MULT_rA_rB_rC:
+					case Opcode.DIV_rA_rB_rC:
+					case Opcode.MOD_rA_rB_rC:
+					case Opcode.INDEX_rA_rB_rC:
+					case Opcode.IDXSET_rA_rB_rC:
+					case Opcode.LT_rA_rB_rC:
+					case Opcode.LE_rA_rB_rC:
+					case Opcode.EQ_rA_rB_rC:
+					case Opcode.NE_rA_rB_rC:
+					case Opcode.ADD_INT_rA_rB_rC:
+					case Opcode.ADD_DBL_rA_rB_rC:
+					case Opcode.SUB_INT_rA_rB_rC:
+					case Opcode.SUB_DBL_rA_rB_rC:
+					case Opcode.MULT_INT_rA_rB_rC:
+					case Opcode.MULT_DBL_rA_rB_rC:
+					case Opcode.LT_INT_rA_rB_rC:
+					case Opcode.LE_INT_rA_rB_rC:
+						maxReg = Math.Max(a, Math.Max(b, c));
+						break;
+
+					case Opcode.LT_rA_rB_iC:
+					case Opcode.LE_rA_rB_iC:
+					case Opcode.EQ_rA_rB_iC:
+					case Opcode.NE_rA_rB_iC:
+						maxReg = Math.Max(a, b);
+						break;
+
+					case Opcode.LT_rA_iB_rC:
+					case Opcode.LE_rA_iB_rC:
+						maxReg = Math.Max(a, c);
+						break;
+
+					case Opcode.JUMP_iABC:
+						branches = true;
+						target = pc + 1 + BytecodeUtil.ABCs(instruction);
+						fallsThrough = false;
+						break;
+
+					case Opcode.BRTRUE_rA_iBC:
+					case Opcode.BRFALSE_rA_iBC:
+					case Opcode.FORPREP_rA_iBC:
+					case Opcode.FORLOOP_rA_iBC:
+					case Opcode.ITER_NEXT_rA_iBC:
+						maxReg = a;
+						if (op == Opcode.FORPREP_rA_iBC || op == Opcode.FORLOOP_rA_iBC) maxReg = a + 2;
+						if (op == Opcode.ITER_NEXT_rA_iBC) maxReg = a + 3;
+						branches = true;
+						target = pc + 1 + BytecodeUtil.BCs(instruction);
+						break;
+
+					case Opcode.BRLT_rA_rB_iC:
+					case Opcode.BRLE_rA_rB_iC:
+					case Opcode.BREQ_rA_rB_iC:
+					case Opcode.BRNE_rA_rB_iC:
+					case Opcode.BRLT_INT_rA_rB_iC:
+					case Opcode.BRLE_INT_rA_rB_iC:
+						maxReg = Math.Max(a, b);
+						branches = true;
+						target = pc + 1 + BytecodeUtil.Cs(instruction);
+						break;
+
+					case Opcode.BRLT_rA_iB_iC:
+					case Opcode.BRLE_rA_iB_iC:
+					case Opcode.BREQ_rA_iB_iC:
+					case Opcode.BRNE_rA_iB_iC:
+					case Opcode.BRLT_INT_rA_iB_iC:
+					case Opcode.BRLE_INT_rA_iB_iC:
+						maxReg = a;
+						branches = true;
+						target = pc + 1 + BytecodeUtil.Cs(instruction);
+						break;
+
+					case Opcode.BRLT_iA_rB_iC:
+					case Opcode.BRLE_iA_rB_iC:
+						maxReg = b;
+						branches = true;
+						target = pc + 1 + BytecodeUtil.Cs(instruction);
+						break;
+
+					case Opcode.IFLT_rA_rB:
+					case Opcode.IFLE_rA_rB:
+					case Opcode.IFEQ_rA_rB:
+					case Opcode.IFNE_rA_rB:
+					case Opcode.IFLT_INT_rA_rB:
+					case Opcode.IFLE_INT_rA_rB:
+						maxReg = Math.Max(a, b);
+						branches = true;
+						target = pc + 2;
+						break;
+
+					case Opcode.IFLT_rA_iBC:
+					case Opcode.IFLE_rA_iBC:
+					case Opcode.IFEQ_rA_iBC:
+					case Opcode.IFNE_rA_iBC:
+					case Opcode.IFLT_INT_rA_iBC:
+					case Opcode.IFLE_INT_rA_iBC:
+						maxReg = a;
+						branches = true;
+						target = pc + 2;
+						break;
+
+					case Opcode.IFLT_iAB_rC:
+					case Opcode.IFLE_iAB_rC:
+						maxReg = c;
+						branches = true;
+						target = pc + 2;
+						break;
+
+					case Opcode.ARGBLK_iABC:
+					case Opcode.ARG_iABC:
+						break;
+
+					case Opcode.CALLF_iA_iBC:
+						// (A is where the callee's window starts, not a register of ours)
+						if (BytecodeUtil.BCu(instruction) >= functions.Count) return AtPC(pc, "invalid function index");
+						break;
+
+					case Opcode.TAILCALLF_iA_iBC:
+						// (@main has no frame to give up: its registers are the globals)
+						if (BytecodeUtil.BCu(instruction) >= functions.Count) return AtPC(pc, "invalid function index");
+						if (func.Name == "@main") return AtPC(pc, "TAILCALLF in @main");
+						fallsThrough = false;
+						break;
+
+					case Opcode.CALLFN_iA_kBC:
+						maxReg = a;
+						constIdx = BytecodeUtil.BCu(instruction);
+						break;
+
+					case Opcode.CALL_rA_rB_rC:
+						maxReg = Math.Max(a, c);
+						break;
+
+					case Opcode.RETURN:
+						fallsThrough = false;
+						break;
+
+					case Opcode.ITER_INIT_rA_rB:
+						maxReg = Math.Max(a + 3, b);
+						break;
+
+					default:
+						return AtPC(pc, "unexpected opcode");
+				}
+
+				if (maxReg >= func.MaxRegs) return AtPC(pc, StringUtils.Format("register r{0} is outside the frame", maxReg));
+				if (constIdx >= func.Constants.Count) return AtPC(pc, StringUtils.Format("invalid constant index {0}", constIdx));
+				if ((op == Opcode.ARG_rA || op == Opcode.ARG_iABC) && !isBlockArg[pc]) return AtPC(pc, "ARG without ARGBLK");
+				if (fallsThrough && pc + 1 >= count) return AtPC(pc, "execution can run off the end of the code");
+				if (branches) {
+					if (target < 0 || target >= count) return AtPC(pc, "branch target out of range");
+					if (isBlockArg[target]) return AtPC(pc, "branch into an ARGBLK");
+				}
+			}
+			return "";
+		}
+
+		private static String AtPC(Int32 pc, String message) {
+			return StringUtils.Format("{0} (at {1})", message, StringUtils.ZeroPad(pc, 4));
+		}
+	}
+
+}
@@ -19,7 +19,7 @@ while [[ $# -gt 0 ]]; do
             ;;
         --help|-h)
             echo "Usage: $0 [-lang=LANGUAGES]"
-            echo "  -lang=LANGUAGES  Run specific languages (msa,cs,cpp-switch,cpp-goto,ms1,python,lua) or 'all' (default)"
+            echo "  -lang=LANGUAGES  Run specific languages (msa,cs,cpp-switch,cpp-goto,cpp-threaded,cpp-tail,ms1,python,lua) or 'all' (default)"
             echo "  Examples:"
             echo "    $0 -lang=msa"
             echo "    $0 -lang=msa,lua"
@@ -79,12 +79,22 @@ verify_result() {
 
 EXPECTED_ITER_FIB="832040"                 # fib(30) * 500000 iterations  
 EXPECTED_RECUR_FIB="3524578"              # fib(33)
+EXPECTED_CALL_FIB="832040"                # fib(30), calling through a funcref
+EXPECTED_GC_GRAPHS="200000"               # deep value + wide sum
+EXPECTED_INTERN_KEYS="99000000"           # sum of i % 1000 over every 10th key
+EXPECTED_LIST_ITER="45000000"             # sum of i % 10 over 10000 items, 1000 times
+EXPECTED_TAIL_SUM="45000000"              # sum of n % 10 for n = 1 to 10000000, by tail calls
 
 # Benchmark definitions  
 BENCHMARKS=(
     "factorial_iterative:Iterative Factorial:unused"
     "iter_fib:Iterative Fibonacci:$EXPECTED_ITER_FIB" 
     "recur_fib:Recursive Fibonacci:$EXPECTED_RECUR_FIB"
+    "call_fib:Funcref-Call Fibonacci:$EXPECTED_CALL_FIB"
+    "gc_graphs:GC Deep/Wide Graphs:$EXPECTED_GC_GRAPHS"
+    "intern_keys:String Interning:$EXPECTED_INTERN_KEYS"
+    "list_iter:List Iteration:$EXPECTED_LIST_ITER"
+    "tail_sum:Tail Recursion:$EXPECTED_TAIL_SUM"
 )
 
 # For quick testing, uncomment the line below to run only one benchmark:
@@ -148,6 +158,8 @@ run_benchmark() {
 declare -a CS_TIMES
 declare -a CPP_GOTO_TIMES
 declare -a CPP_SWITCH_TIMES
+declare -a CPP_THREADED_TIMES
+declare -a CPP_TAIL_TIMES
 declare -a MS_TIMES
 declare -a PY_TIMES
 declare -a LUA_TIMES
@@ -211,6 +223,46 @@ if should_run_language "cpp-goto" || should_run_language "msa"; then
     echo ""
 fi
 
+# Build and run all C++ (direct-threaded) benchmarks
+if should_run_language "cpp-threaded"; then
+    echo -e "${BOLD}Building C++ version (direct-threaded)...${NC}"
+    rm -f build/cpp/obj/* build/cpp/MS2Proto3 2>/dev/null
+    if ! tools/build.sh cpp threaded; then
+        echo -e "${RED}C++ (direct-threaded) build failed!${NC}"
+        exit 1
+    fi
+    echo -e "${BOLD}Running C++ (direct-threaded) benchmarks...${NC}"
+    for i in "${!BENCHMARKS[@]}"; do
+        benchmark_def="${BENCHMARKS[i]}"
+        IFS=':' read -r file name expected <<< "$benchmark_def"
+
+        echo -e "${BLUE}  $name...${NC}"
+        cpp_threaded_time=$(run_benchmark "$file" "$name" "$expected" "C++ (direct-threaded)" "build/cpp/MS2Proto3")
+        CPP_THREADED_TIMES+=("$cpp_threaded_time")
+    done
+    echo ""
+fi
+
+# Build and run all C++ (tail-call) benchmarks
+if should_run_language "cpp-tail"; then
+    echo -e "${BOLD}Building C++ version (tail-call)...${NC}"
+    rm -f build/cpp/obj/* build/cpp/MS2Proto3 2>/dev/null
+    if ! tools/build.sh cpp tail; then
+        echo -e "${RED}C++ (tail-call) build failed!${NC}"
+        exit 1
+    fi
+    echo -e "${BOLD}Running C++ (tail-call) benchmarks...${NC}"
+    for i in "${!BENCHMARKS[@]}"; do
+        benchmark_def="${BENCHMARKS[i]}"
+        IFS=':' read -r file name expected <<< "$benchmark_def"
+
+        echo -e "${BLUE}  $name...${NC}"
+        cpp_tail_time=$(run_benchmark "$file" "$name" "$expected" "C++ (tail-call)" "build/cpp/MS2Proto3")
+        CPP_TAIL_TIMES+=("$cpp_tail_time")
+    done
+    echo ""
+fi
+
 # Run all MiniScript benchmarks
 if should_run_language "ms1"; then
     echo -e "${BOLD}Running MiniScript benchmarks...${NC}"
@@ -280,6 +332,18 @@ if should_run_language "cpp-goto" || should_run_language "msa"; then
     format_string+="| %-10s "
 fi
 
+if should_run_language "cpp-threaded"; then
+    table_header+="| C++ (threaded) "
+    table_separator+="|----------------"
+    format_string+="| %-14s "
+fi
+
+if should_run_language "cpp-tail"; then
+    table_header+="| C++ (tail) "
+    table_separator+="|------------"
+    format_string+="| %-10s "
+fi
+
 if should_run_language "ms1"; then
     table_header+="|  MS 1.0  "
     table_separator+="|----------"
@@ -324,6 +388,14 @@ for i in "${!BENCHMARKS[@]}"; do
         printf_args+=("${CPP_GOTO_TIMES[i]}s")
     fi
 
+    if should_run_language "cpp-threaded"; then
+        printf_args+=("${CPP_THREADED_TIMES[i]}s")
+    fi
+
+    if should_run_language "cpp-tail"; then
+        printf_args+=("${CPP_TAIL_TIMES[i]}s")
+    fi
+
     if should_run_language "ms1"; then
         printf_args+=("${MS1_TIMES[i]}s")
     fi
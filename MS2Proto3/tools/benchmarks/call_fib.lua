@@ -0,0 +1,7 @@
+function rfib(n, f)
+    if n < 2 then return n end
+    return f(n-1, f) + f(n-2, f)
+end
+
+print("Result in r0:")
+print(rfib(30, rfib))
\ No newline at end of file
@@ -0,0 +1,10 @@
+#!/usr/bin/env python3
+"""Recursive Fibonacci sequence, calling through a function reference."""
+
+def rfib(n, f):
+    if n < 2:
+        return n
+    return f(n-1, f) + f(n-2, f)
+
+print("Result in r0:")
+print(rfib(30, rfib))
\ No newline at end of file
@@ -0,0 +1,35 @@
+-- GC benchmark: deep and wide object graphs
+n = 100000
+
+deep = {n}
+for i = 1, n, 1 do
+    deep = {deep}
+end
+
+wide = {}
+for i = 1, n / 1000, 1 do
+    row = {}
+    for j = 1, 1000, 1 do
+        row[j] = {1, 1}
+    end
+    wide[i] = row
+end
+
+ring = {}
+for i = 0, 1999999, 1 do
+    ring[i % 20000 + 1] = {i}
+end
+ring = nil
+
+for i = 1, n, 1 do
+    deep = deep[1]
+end
+answer = deep[1]
+for i = 1, n / 1000, 1 do
+    for j = 1, 1000, 1 do
+        answer = answer + wide[i][j][1]
+    end
+end
+
+print("Result in r0:")
+print(answer)
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+
+# GC benchmark: deep and wide object graphs
+n = 100000
+
+deep = [n]
+for i in range(n):
+    deep = [deep]
+
+wide = []
+for i in range(n // 1000):
+    row = []
+    for j in range(1000):
+        row.append([1, 1])
+    wide.append(row)
+
+ring = [0] * 20000
+for i in range(2000000):
+    ring[i % 20000] = [i]
+ring = None
+
+for i in range(n):
+    deep = deep[0]
+answer = deep[0]
+for row in wide:
+    for item in row:
+        answer = answer + item[0]
+
+print("Result in r0:")
+print(answer)
@@ -0,0 +1,16 @@
+-- String interning benchmark: many distinct short strings
+n = 2000000
+
+map = {}
+for i = 0, n - 1, 1 do
+    key = "k" .. i
+    if i % 10 == 0 then map[key] = i % 1000 end
+end
+
+answer = 0
+for i = 0, n - 1, 10 do
+    answer = answer + map["k" .. i]
+end
+
+print("Result in r0:")
+print(answer)
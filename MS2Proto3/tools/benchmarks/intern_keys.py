@@ -0,0 +1,17 @@
+#!/usr/bin/env python3
+
+# String interning benchmark: many distinct short strings
+n = 2000000
+
+map = {}
+for i in range(n):
+    key = "k" + str(i)
+    if i % 10 == 0:
+        map[key] = i % 1000
+
+answer = 0
+for i in range(0, n, 10):
+    answer = answer + map["k" + str(i)]
+
+print("Result in r0:")
+print(answer)
@@ -0,0 +1,13 @@
+local list = {}
+for i = 0, 9999, 1 do
+    list[#list + 1] = i % 10
+end
+
+answer = 0
+for p = 1, 1000, 1 do
+    for _, item in ipairs(list) do
+        answer = answer + item
+    end
+end
+print("Result in r0:")
+print(answer)
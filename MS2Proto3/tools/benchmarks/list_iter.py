@@ -0,0 +1,14 @@
+#!/usr/bin/env python3
+
+# List iteration benchmark
+lst = []
+for i in range(10000):
+    lst.append(i % 10)
+
+answer = 0
+for p in range(1000):
+    for item in lst:
+        answer = answer + item
+
+print("Result in r0:")
+print(answer)
@@ -0,0 +1,8 @@
+-- Lua has proper tail calls, so this recursion runs in constant stack space
+local function step(n, acc)
+    if n == 0 then return acc end
+    return step(n - 1, acc + n % 10)
+end
+
+print("Result in r0:")
+print(step(10000000, 0))
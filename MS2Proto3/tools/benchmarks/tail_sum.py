@@ -0,0 +1,12 @@
+#!/usr/bin/env python3
+
+# Python has no tail calls (recursion ten million deep would overflow
+# the stack), so this is the loop the tail calls amount to.
+n = 10000000
+acc = 0
+while n != 0:
+    acc = acc + n % 10
+    n = n - 1
+
+print("Result in r0:")
+print(acc)
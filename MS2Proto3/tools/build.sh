@@ -11,7 +11,7 @@ echo "Project root: $(pwd)"
 
 # Parse command line arguments
 TARGET="${1:-all}"
-GOTO_MODE="${2:-auto}"  # auto, on, off
+GOTO_MODE="${2:-auto}"  # auto, on, off, threaded, tail
 
 case "$TARGET" in
     "setup")
@@ -69,6 +69,14 @@ case "$TARGET" in
                 echo "Forcing computed-goto OFF"
                 make -C cpp GOTO_MODE=off
                 ;;
+            "threaded")
+                echo "Forcing computed-goto ON, with direct threading"
+                make -C cpp GOTO_MODE=threaded
+                ;;
+            "tail")
+                echo "Using tail-call dispatch (one function per opcode)"
+                make -C cpp GOTO_MODE=tail
+                ;;
             *)
                 echo "Using auto-detected computed-goto"
                 make -C cpp
@@ -120,6 +128,8 @@ case "$TARGET" in
         echo "  auto      - Auto-detect computed-goto support (default)"
         echo "  on        - Force computed-goto ON"
         echo "  off       - Force computed-goto OFF"
+        echo "  threaded  - Direct-threaded dispatch (handler addresses per instruction)"
+        echo "  tail      - Tail-call dispatch (one function per opcode)"
         exit 1
         ;;
 esac
@@ -61,8 +61,10 @@ static Proto *make_main_proto(int nval) {
 	return p;
 }
 
-int main(void) {
-	if (vm_uses_goto()) {
+int main(int argc, char **argv) {
+	if (vm_uses_tail_calls()) {
+		printf("VM using tail calls\n");
+	} else if (vm_uses_goto()) {
 		printf("VM using computed goto\n");
 	} else {
 		printf("VM using portable switch\n");
@@ -70,7 +72,7 @@ int main(void) {
 
 	VM vm; vm_init(&vm, /*stack_slots*/ 4096, /*call_slots*/ 1024);
 
-	int n = 40;	// Fibonacci number to compute
+	int n = argc > 1 ? atoi(argv[1]) : 40;	// Fibonacci number to compute
 	Proto *fib  = make_fib_proto();
 	Proto *mainp = make_main_proto(n);
 
@@ -1,4 +1,4 @@
-// Tiny portable VM with optional computed-goto dispatch.
+// Tiny portable VM with optional computed-goto or tail-call dispatch.
 // VM implementation
 
 #include "tiny_vm.h"
@@ -21,8 +21,38 @@
 #  endif
 #endif
 
-// Dispatch macros (computed-goto OR portable switch)
-#if VM_USE_COMPUTED_GOTO
+// Tail-call dispatch is off unless asked for (-DVM_USE_TAIL_CALLS=1).  Each
+// opcode then gets a function of its own, which ends by calling the handler
+// of the next instruction, with the VM state passed in argument registers.
+// That call must become a jump: we ask for that with `musttail` where the
+// compiler supports it (Clang), and otherwise rely on the optimizer (GCC
+// does it at -O2 and up).
+#ifndef VM_USE_TAIL_CALLS
+#  define VM_USE_TAIL_CALLS 0
+#endif
+
+// Dispatch macros (tail calls, computed-goto OR portable switch)
+#if VM_USE_TAIL_CALLS
+	#if defined(__has_attribute)
+	#  if __has_attribute(musttail)
+	#    define VM_MUSTTAIL __attribute__((musttail))
+	#  endif
+	#endif
+	#ifndef VM_MUSTTAIL
+	#  define VM_MUSTTAIL
+	#endif
+
+	#define VM_HANDLER_PARAMS VM *vm, uint32_t *pc, Value *base, uint32_t ins
+	typedef int (*vm_handler)(VM_HANDLER_PARAMS);
+
+	#define VM_HANDLER_DECL(OP) static int h_##OP(VM_HANDLER_PARAMS);
+	#define VM_HANDLER_LIST(OP) h_##OP,
+	VM_OPCODES(VM_HANDLER_DECL)
+	static const vm_handler vm_handlers[op__COUNT];
+
+	#define VM_CASE(OP)     static int h_##OP(VM_HANDLER_PARAMS)
+	#define VM_NEXT()       do { ins = *pc++; VM_MUSTTAIL return vm_handlers[OP(ins)](vm, pc, base, ins); } while (0)
+#elif VM_USE_COMPUTED_GOTO
 	// Computed-goto: build a label table inside the function.
 	// Important: include commas between entries!
 	#define VM_LABEL_ADDR(OP) &&L_##OP
@@ -55,7 +85,15 @@ void vm_free(VM *vm) {
 }
 
 bool vm_uses_goto(void) {
-#if VM_USE_COMPUTED_GOTO
+#if VM_USE_COMPUTED_GOTO && !VM_USE_TAIL_CALLS
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool vm_uses_tail_calls(void) {
+#if VM_USE_TAIL_CALLS
 	return true;
 #else
 	return false;
@@ -66,6 +104,9 @@ static void ensure_frame(VM *vm, Value *base, uint16_t need) {
 	(void)vm; (void)base; (void)need; // stack is pre-allocated large enough in this demo
 }
 
+// With tail calls, the opcode handlers below are functions of their own
+// (see VM_CASE), so they come before vm_exec rather than inside it.
+#if !VM_USE_TAIL_CALLS
 int vm_exec(VM *vm, Proto *entry) {
 	// Current frame state (kept in locals for speed)
 	Value    *base = vm->stack;                   // entry executes at stack base
@@ -79,6 +120,7 @@ int vm_exec(VM *vm, Proto *entry) {
 	uint32_t ins;
 
 	VM_DISPATCH_BEGIN();
+#endif
 
 	VM_CASE(MOVE) {
 		// NOTE: we are assuming here that we never need more than 255 registers,
@@ -157,8 +199,21 @@ int vm_exec(VM *vm, Proto *entry) {
 		VM_NEXT();
 	}
 
+#if VM_USE_TAIL_CALLS
+static const vm_handler vm_handlers[op__COUNT] = { VM_OPCODES(VM_HANDLER_LIST) };
+
+int vm_exec(VM *vm, Proto *entry) {
+	Value    *base = vm->stack;                   // entry executes at stack base
+	uint32_t *pc   = entry->code;                 // start at entry code
+	ensure_frame(vm, base, entry->max_regs);
+
+	uint32_t ins = *pc++;
+	return vm_handlers[OP(ins)](vm, pc, base, ins);
+}
+#else
 	VM_DISPATCH_END();
 
 	// Unreachable
 	return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -58,5 +58,6 @@ void vm_init(VM *vm, size_t stack_slots, size_t call_slots);
 void vm_free(VM *vm);
 int vm_exec(VM *vm, Proto *entry);
 bool vm_uses_goto(void);
+bool vm_uses_tail_calls(void);
 
 #endif // TINY_VM_H
\ No newline at end of file